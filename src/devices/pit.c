@@ -81,3 +81,93 @@ pit_configure_channel (int channel, int mode, int frequency)
   outb (PIT_PORT_COUNTER (channel), count >> 8);
   intr_set_level (old_level);
 }
+
+/* Returns the number of PIT cycles in one period of a FREQUENCY
+   Hz clock, rounded to nearest, as pit_configure_channel()
+   programs it. */
+unsigned
+pit_period_count (int frequency)
+{
+  ASSERT (frequency >= 19 && frequency <= PIT_HZ);
+
+  return (PIT_HZ + frequency / 2) / frequency;
+}
+
+/* Arms CHANNEL, which must be channel 0, as a one-shot timer
+   that raises its output (and thus interrupt line 0) once, COUNT
+   PIT cycles from now.  Mode 0, "interrupt on terminal count",
+   is used.  Reprogram the channel with pit_configure_channel()
+   to return to periodic operation. */
+void
+pit_start_oneshot (int channel, unsigned count)
+{
+  enum intr_level old_level;
+
+  ASSERT (channel == 0);
+  ASSERT (count > 0 && count <= UINT16_MAX);
+
+  old_level = intr_disable ();
+  outb (PIT_PORT_CONTROL, (channel << 6) | 0x30 | (0 << 1));
+  outb (PIT_PORT_COUNTER (channel), count);
+  outb (PIT_PORT_COUNTER (channel), count >> 8);
+  intr_set_level (old_level);
+}
+
+/* Latches CHANNEL's status and count with a read-back command
+   and returns the count, storing the status byte in *STATUS.
+   Status bit 7 is the state of the channel's output pin; bit 6
+   is set while a newly written count has not yet been loaded
+   into the counter, during which the count read is stale. */
+static unsigned
+read_back (int channel, uint8_t *status)
+{
+  unsigned count;
+  enum intr_level old_level;
+
+  old_level = intr_disable ();
+  outb (PIT_PORT_CONTROL, 0xc0 | (1 << (channel + 1)));
+  *status = inb (PIT_PORT_COUNTER (channel));
+  count = inb (PIT_PORT_COUNTER (channel));
+  count |= inb (PIT_PORT_COUNTER (channel)) << 8;
+  intr_set_level (old_level);
+
+  return count;
+}
+
+/* Returns the number of PIT cycles left before CHANNEL, running
+   in periodic mode, next raises its output. */
+unsigned
+pit_read_count (int channel)
+{
+  uint8_t status;
+  unsigned count;
+
+  ASSERT (channel == 0);
+
+  count = read_back (channel, &status);
+  return count != 0 ? count : UINT16_MAX + 1;
+}
+
+/* Checks on the one-shot that pit_start_oneshot() armed on
+   CHANNEL for COUNT cycles.  Returns false if it has expired.
+   Otherwise, returns true and stores the cycles still to go in
+   *REMAINING.  Expiry is read from the output pin, which mode 0
+   holds high from terminal count until the channel is
+   reprogrammed, rather than from the counter, which keeps
+   counting down past zero and wraps. */
+bool
+pit_oneshot_pending (int channel, unsigned count, unsigned *remaining)
+{
+  uint8_t status;
+  unsigned left;
+
+  ASSERT (channel == 0);
+
+  left = read_back (channel, &status);
+  if (status & 0x80)
+    return false;
+  if ((status & 0x40) || left > count)
+    left = count;
+  *remaining = left;
+  return true;
+}
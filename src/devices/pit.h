@@ -1,8 +1,13 @@
 #ifndef DEVICES_PIT_H
 #define DEVICES_PIT_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 void pit_configure_channel (int channel, int mode, int frequency);
+unsigned pit_period_count (int frequency);
+unsigned pit_read_count (int channel);
+void pit_start_oneshot (int channel, unsigned count);
+bool pit_oneshot_pending (int channel, unsigned count, unsigned *remaining);
 
 #endif /* devices/pit.h */
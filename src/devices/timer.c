@@ -7,6 +7,7 @@
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -24,7 +25,39 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* If false (default), the PIT interrupts TIMER_FREQ times per
+   second no matter what.
+   If true, the PIT is armed as a one-shot timer for the next tick
+   the running thread needs taken on time: the next sleeper
+   deadline or the end of its time slice, whichever is first.
+   The ticks in between are replayed when the one-shot fires.
+   Controlled by kernel command-line option "-tickless". */
+bool timer_tickless;
+
+/* PIT cycles per timer tick. */
+static unsigned tick_count;
+
+/* The armed one-shot: the number of tick boundaries it runs to,
+   or 0 if the PIT is in its normal periodic mode; the PIT cycles
+   it was armed for; and the cycles from arming to its first tick
+   boundary, which keeps the ticks it stands in for in phase with
+   the periodic ones. */
+static int oneshot_ticks;
+static unsigned oneshot_count;
+static unsigned oneshot_first;
+
+/* Whole ticks that passed under a one-shot that was re-armed
+   before it expired.  The next timer interrupt credits them. */
+static int pending_ticks;
+
+/* Runs the advanced scheduler's once-per-second recomputation
+   pass outside the timer interrupt. */
+static struct work mlfqs_decay_work;
+
 static intr_handler_func timer_interrupt;
+static work_func mlfqs_decay;
+static void timer_advance(int elapsed, bool user);
+static int oneshot_elapsed(unsigned *rest);
 static bool too_many_loops(unsigned loops);
 static void busy_wait(int64_t loops);
 static void real_time_sleep(int64_t num, int32_t denom);
@@ -35,7 +68,9 @@ static void real_time_delay(int64_t num, int32_t denom);
 void timer_init(void)
 {
   pit_configure_channel(0, 2, TIMER_FREQ);
+  tick_count = pit_period_count(TIMER_FREQ);
   intr_register_ext(0x20, timer_interrupt, "8254 Timer");
+  work_init(&mlfqs_decay_work, mlfqs_decay);
 }
 
 /* Calibrates loops_per_tick, used to implement brief delays. */
@@ -64,12 +99,21 @@ void timer_calibrate(void)
   printf("%'" PRIu64 " loops/s.\n", (uint64_t)loops_per_tick * TIMER_FREQ);
 }
 
-/* Returns the number of timer ticks since the OS booted. */
+/* Returns the number of timer ticks since the OS booted.  This
+   includes ticks that an armed one-shot has passed but not yet
+   credited. */
 int64_t
 timer_ticks(void)
 {
   enum intr_level old_level = intr_disable();
-  int64_t t = ticks;
+  int64_t t = ticks + pending_ticks;
+  unsigned rest;
+
+  if (oneshot_ticks != 0)
+  {
+    int elapsed = oneshot_elapsed(&rest);
+    t += elapsed >= 0 ? elapsed : oneshot_ticks;
+  }
   intr_set_level(old_level);
   return t;
 }
@@ -158,31 +202,143 @@ void timer_print_stats(void)
   printf("Timer: %" PRId64 " ticks\n", timer_ticks());
 }
 
+/* Advanced scheduler work for one tick.  Only the work that
+   concerns the interrupted thread, or that must see the run
+   queues as they are at this tick, is done here.  The decay pass
+   over every runnable thread is handed to the worker thread,
+   which runs it as soon as this interrupt returns.  The worker
+   is left out of load_avg, so waking it does not count as
+   load. */
 void handle_mlfqs(void)
 {
   incrementRecentCpu();
   if (ticks % TIMER_FREQ == 0)
   {
     calculateLoadAvg();
-    thread_foreach(calculateRecentCpu, NULL);
+    work_queue(&mlfqs_decay_work);
   }
   if (ticks % 4 == 0)
   {
-    updateAllPriorities();
+    updateCurrentPriority();
   }
 }
 
+/* Decays recent_cpu and recomputes priorities once a second, in
+   the worker thread. */
+static void
+mlfqs_decay(struct work *w UNUSED)
+{
+  decayAllRecentCpu();
+}
+
+/* Accounts for ELAPSED timer ticks, doing for each one the work
+   a periodic timer interrupt would have done.  USER is true if
+   the ticks interrupted user code. */
+static void
+timer_advance(int elapsed, bool user)
+{
+  while (elapsed-- > 0)
+  {
+    ticks++;
+    thread_wake_sleeping_threads(ticks);
+    thread_tick(user);
+    if (thread_mlfqs)
+    {
+      handle_mlfqs();
+    }
+  }
+}
+
+/* Returns the number of tick boundaries the armed one-shot has
+   passed and stores in *REST the PIT cycles left to the next
+   one.  Returns -1 if the one-shot has expired, in which case
+   its interrupt is pending. */
+static int
+oneshot_elapsed(unsigned *rest)
+{
+  unsigned remaining, counted;
+
+  if (!pit_oneshot_pending(0, oneshot_count, &remaining))
+    return -1;
+
+  counted = oneshot_count - remaining;
+  if (counted < oneshot_first)
+  {
+    *rest = oneshot_first - counted;
+    return 0;
+  }
+  counted -= oneshot_first;
+  *rest = tick_count - counted % tick_count;
+  return 1 + counted / tick_count;
+}
+
+/* In tickless mode, arms the PIT for the next tick the running
+   thread needs taken on time, or puts it back in periodic mode
+   if that is the very next tick.  Ticks a re-armed one-shot has
+   already passed are carried in pending_ticks, and the new
+   one-shot starts from the part of the current tick that is
+   left, so no time is lost or gained.  The 16-bit PIT counter
+   limits a single one-shot to a few ticks.  Called with
+   interrupts off on each context switch and after each timer
+   interrupt. */
+void timer_tickless_update(void)
+{
+  int64_t delta;
+  unsigned first;
+  int elapsed = 0;
+  int limit;
+
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  /* Threads can be switched before timer_init() has run. */
+  if (!timer_tickless || tick_count == 0)
+    return;
+
+  if (oneshot_ticks == 0)
+    first = pit_read_count(0);
+  else
+  {
+    elapsed = oneshot_elapsed(&first);
+    if (elapsed < 0)
+      return;
+  }
+
+  delta = thread_next_wake_tick() - (ticks + pending_ticks + elapsed);
+  if (delta > thread_ticks_to_preempt())
+    delta = thread_ticks_to_preempt();
+  limit = 1 + (UINT16_MAX - first) / tick_count;
+  if (delta > limit)
+    delta = limit;
+  if (delta < 1)
+    delta = 1;
+
+  if (oneshot_ticks == 0 ? delta == 1 : elapsed + delta == oneshot_ticks)
+    return;
+
+  pending_ticks += elapsed;
+  oneshot_ticks = delta;
+  oneshot_first = first;
+  oneshot_count = first + (delta - 1) * tick_count;
+  pit_start_oneshot(0, oneshot_count);
+}
+
 /* Timer interrupt handler. */
 static void
-timer_interrupt(struct intr_frame *args UNUSED)
+timer_interrupt(struct intr_frame *args)
 {
-  ticks++;
-  thread_wake_sleeping_threads(ticks);
-  thread_tick();
-  if (thread_mlfqs)
+  int elapsed = 1;
+
+  if (oneshot_ticks != 0)
   {
-    handle_mlfqs();
+    elapsed = oneshot_ticks + pending_ticks;
+    oneshot_ticks = 0;
+    pending_ticks = 0;
+    pit_configure_channel(0, 2, TIMER_FREQ);
   }
+  /* The low 2 bits of a code selector are its privilege level,
+     3 for user code. */
+  timer_advance(elapsed, (args->cs & 3) == 3);
+  timer_tickless_update();
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -191,17 +347,17 @@ static bool
 too_many_loops(unsigned loops)
 {
   /* Wait for a timer tick. */
-  int64_t start = ticks;
-  while (ticks == start)
+  int64_t start = timer_ticks();
+  while (timer_ticks() == start)
     barrier();
 
   /* Run LOOPS loops. */
-  start = ticks;
+  start = timer_ticks();
   busy_wait(loops);
 
   /* If the tick count changed, we iterated too long. */
   barrier();
-  return start != ticks;
+  return start != timer_ticks();
 }
 
 /* Iterates through a simple loop LOOPS times, for implementing
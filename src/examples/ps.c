@@ -0,0 +1,60 @@
+/* ps.c
+
+   Prints the CPU time, context switches, and page faults of
+   every running process, summed over all of its threads.
+
+   Any arguments are names of programs to start first, so that
+   their usage shows up alongside everything else that is running;
+   ps waits for them before exiting.  For example, "ps matmult
+   bubsort" starts both and shows which of them is using the
+   CPU. */
+
+#include <rusage.h>
+#include <stdio.h>
+#include <syscall.h>
+
+/* Highest pid to look for, beyond the highest pid ps has seen.
+   Pids are handed out in increasing order, so a process that
+   ps did not start itself most likely has a pid below its own
+   children's. */
+#define PID_SLACK 256
+
+int
+main (int argc, char *argv[])
+{
+  pid_t children[32];
+  pid_t pid, max_pid = 0;
+  struct rusage usage;
+  int child_cnt = 0;
+  int i;
+
+  for (i = 1; i < argc && child_cnt < 32; i++) 
+    {
+      pid = exec (argv[i]);
+      if (pid == PID_ERROR)
+        printf ("ps: %s: exec failed\n", argv[i]);
+      else
+        {
+          children[child_cnt++] = pid;
+          if (pid > max_pid)
+            max_pid = pid;
+        }
+    }
+
+  printf ("%5s %8s %8s %6s %6s %6s\n",
+          "PID", "USER", "KERNEL", "VCSW", "ICSW", "FAULTS");
+  for (pid = 1; pid <= max_pid + PID_SLACK; pid++)
+    if (getrusage (pid, &usage))
+      printf ("%5d %8lld %8lld %6u %6u %6u\n",
+              pid, usage.user_ticks, usage.kernel_ticks,
+              usage.voluntary_switches, usage.involuntary_switches,
+              usage.page_faults);
+
+  if (getrusage (RUSAGE_SELF, &usage))
+    printf ("ps itself: %lld user, %lld kernel ticks\n",
+            usage.user_ticks, usage.kernel_ticks);
+
+  for (i = 0; i < child_cnt; i++)
+    wait (children[i]);
+  return EXIT_SUCCESS;
+}
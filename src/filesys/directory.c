@@ -4,7 +4,7 @@
 #include <list.h>
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
-#include "threads/malloc.h"
+#include "threads/kmem.h"
 
 /* A directory. */
 struct dir 
@@ -13,6 +13,11 @@ struct dir
     off_t pos;                          /* Current position. */
   };
 
+/* Cache of struct dir. */
+static struct kmem_cache dir_cache =
+  KMEM_CACHE_INITIALIZER ("dir", sizeof (struct dir),
+                          __alignof__ (struct dir), NULL);
+
 /* A single directory entry. */
 struct dir_entry 
   {
@@ -34,7 +39,7 @@ dir_create (block_sector_t sector, size_t entry_cnt)
 struct dir *
 dir_open (struct inode *inode) 
 {
-  struct dir *dir = calloc (1, sizeof *dir);
+  struct dir *dir = kmem_cache_alloc (&dir_cache);
   if (inode != NULL && dir != NULL)
     {
       dir->inode = inode;
@@ -44,7 +49,7 @@ dir_open (struct inode *inode)
   else
     {
       inode_close (inode);
-      free (dir);
+      kmem_cache_free (&dir_cache, dir);
       return NULL; 
     }
 }
@@ -72,7 +77,7 @@ dir_close (struct dir *dir)
   if (dir != NULL)
     {
       inode_close (dir->inode);
-      free (dir);
+      kmem_cache_free (&dir_cache, dir);
     }
 }
 
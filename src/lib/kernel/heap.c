@@ -0,0 +1,210 @@
+/* Pairing heap.
+
+   See heap.h for basic information.
+
+   The heap is a tree in which every node is at least as great as
+   each of its children.  A node's children form a doubly linked
+   sibling list hanging off its `child' member; the leftmost
+   child's `prev' points back to the parent instead of to a
+   sibling, which lets an arbitrary node be cut out in O(1).
+
+   Two trees are "melded" by making the lesser root the leftmost
+   child of the greater.  Removing a root leaves a list of
+   subtrees, which are combined by the standard two-pass pairing:
+   meld them in pairs from left to right, then meld the results
+   from right to left. */
+
+#include "heap.h"
+#include "../debug.h"
+
+static bool goes_before (const struct heap *,
+                         const struct heap_elem *, const struct heap_elem *);
+static struct heap_elem *meld (const struct heap *,
+                               struct heap_elem *, struct heap_elem *);
+static struct heap_elem *merge_pairs (const struct heap *, struct heap_elem *);
+
+/* Initializes heap H as an empty heap that compares elements
+   using LESS, given auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux)
+{
+  ASSERT (h != NULL);
+  ASSERT (less != NULL);
+
+  h->root = NULL;
+  h->elem_cnt = 0;
+  h->next_seq = 0;
+  h->less = less;
+  h->aux = aux;
+}
+
+/* Inserts E into heap H. */
+void
+heap_insert (struct heap *h, struct heap_elem *e)
+{
+  ASSERT (h != NULL);
+  ASSERT (e != NULL);
+
+  e->child = e->next = e->prev = NULL;
+  e->seq = h->next_seq++;
+  h->root = meld (h, h->root, e);
+  h->elem_cnt++;
+}
+
+/* Removes and returns the greatest element in H, which must not
+   be empty. */
+struct heap_elem *
+heap_pop (struct heap *h)
+{
+  struct heap_elem *max;
+
+  ASSERT (!heap_empty (h));
+
+  max = h->root;
+  h->root = merge_pairs (h, max->child);
+  h->elem_cnt--;
+  max->child = NULL;
+  return max;
+}
+
+/* Removes E, which must be in H, from H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e)
+{
+  ASSERT (!heap_empty (h));
+  ASSERT (e != NULL);
+
+  if (e == h->root)
+    {
+      heap_pop (h);
+      return;
+    }
+
+  /* Cut E's subtree out of its parent's child list. */
+  if (e->prev->child == e)
+    e->prev->child = e->next;
+  else
+    e->prev->next = e->next;
+  if (e->next != NULL)
+    e->next->prev = e->prev;
+  e->next = e->prev = NULL;
+
+  /* Put E's children back in place of E. */
+  h->root = meld (h, h->root, merge_pairs (h, e->child));
+  e->child = NULL;
+  h->elem_cnt--;
+}
+
+/* Restores the heap ordering of H after the value that H's less
+   function sees for E, which must be in H, has changed.  E is
+   ordered after any elements that now compare equal to it. */
+void
+heap_update (struct heap *h, struct heap_elem *e)
+{
+  heap_remove (h, e);
+  heap_insert (h, e);
+}
+
+/* Returns the greatest element in H without removing it, or a
+   null pointer if H is empty. */
+struct heap_elem *
+heap_max (struct heap *h)
+{
+  ASSERT (h != NULL);
+
+  return h->root;
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (struct heap *h)
+{
+  return h->elem_cnt;
+}
+
+/* Returns true if H is empty, false otherwise. */
+bool
+heap_empty (struct heap *h)
+{
+  return h->root == NULL;
+}
+
+/* Returns true if A must come out of H before B: either A is
+   greater than B, or they are equal and A was inserted first. */
+static bool
+goes_before (const struct heap *h,
+             const struct heap_elem *a, const struct heap_elem *b)
+{
+  if (h->less (b, a, h->aux))
+    return true;
+  if (h->less (a, b, h->aux))
+    return false;
+  return (int) (a->seq - b->seq) < 0;
+}
+
+/* Melds the trees rooted at A and B, either of which may be
+   null, and returns the root of the result.  A and B must not
+   have siblings. */
+static struct heap_elem *
+meld (const struct heap *h, struct heap_elem *a, struct heap_elem *b)
+{
+  if (a == NULL)
+    return b;
+  if (b == NULL)
+    return a;
+
+  if (goes_before (h, b, a))
+    {
+      struct heap_elem *tmp = a;
+      a = b;
+      b = tmp;
+    }
+
+  /* Make B the leftmost child of A. */
+  b->prev = a;
+  b->next = a->child;
+  if (a->child != NULL)
+    a->child->prev = b;
+  a->child = b;
+  return a;
+}
+
+/* Combines the sibling list that starts at FIRST into a single
+   tree by two-pass pairing and returns its root, or a null
+   pointer if FIRST is null. */
+static struct heap_elem *
+merge_pairs (const struct heap *h, struct heap_elem *first)
+{
+  struct heap_elem *pairs = NULL;
+  struct heap_elem *root = NULL;
+
+  /* First pass: meld adjacent pairs left to right, stacking the
+     results on PAIRS so that the rightmost ends up on top. */
+  while (first != NULL)
+    {
+      struct heap_elem *a = first;
+      struct heap_elem *b = a->next;
+      struct heap_elem *m;
+
+      first = b != NULL ? b->next : NULL;
+      a->next = a->prev = NULL;
+      if (b != NULL)
+        b->next = b->prev = NULL;
+      m = meld (h, a, b);
+      m->next = pairs;
+      pairs = m;
+    }
+
+  /* Second pass: meld the pairs right to left. */
+  while (pairs != NULL)
+    {
+      struct heap_elem *next = pairs->next;
+      pairs->next = NULL;
+      root = meld (h, root, pairs);
+      pairs = next;
+    }
+
+  if (root != NULL)
+    root->prev = NULL;
+  return root;
+}
@@ -0,0 +1,25 @@
+#ifndef __LIB_RUSAGE_H
+#define __LIB_RUSAGE_H
+
+#include <stdint.h>
+
+/* Resources used by a thread or a process, as reported by the
+   getrusage system call.  Shared by the kernel and user
+   programs. */
+struct rusage
+  {
+    int64_t user_ticks;         /* Timer ticks spent in user mode. */
+    int64_t kernel_ticks;       /* Timer ticks spent in the kernel. */
+    unsigned voluntary_switches;   /* Times the CPU was given up to
+                                      block. */
+    unsigned involuntary_switches; /* Times the CPU was taken away
+                                      while still runnable. */
+    unsigned page_faults;       /* Page faults taken. */
+  };
+
+/* Special values for the WHO argument to getrusage().  Any other
+   value is the pid of a process to report on. */
+#define RUSAGE_SELF 0           /* All threads of this process. */
+#define RUSAGE_THREAD -1        /* The calling thread alone. */
+
+#endif /* lib/rusage.h */
@@ -0,0 +1,83 @@
+#include <mutex.h>
+#include <debug.h>
+#include <stddef.h>
+#include <syscall.h>
+
+/* Atomically replaces *P by NEW if it holds OLD.  Returns the
+   value *P held before, which equals OLD on success. */
+static inline int
+cmpxchg (volatile int *p, int old, int new) 
+{
+  int prev;
+  asm volatile ("lock cmpxchgl %2, %1"
+                : "=a" (prev), "+m" (*p)
+                : "r" (new), "0" (old)
+                : "memory");
+  return prev;
+}
+
+/* Atomically stores NEW into *P and returns the old value. */
+static inline int
+xchg (volatile int *p, int new) 
+{
+  asm volatile ("xchgl %0, %1" : "+r" (new), "+m" (*p) : : "memory");
+  return new;
+}
+
+/* Initializes M as a free mutex. */
+void
+mutex_init (struct mutex *m) 
+{
+  ASSERT (m != NULL);
+  m->state = MUTEX_FREE;
+}
+
+/* Acquires M, waiting if necessary until it is free.  M is not
+   recursive. */
+void
+mutex_lock (struct mutex *m) 
+{
+  int state;
+
+  ASSERT (m != NULL);
+
+  state = cmpxchg (&m->state, MUTEX_FREE, MUTEX_HELD);
+  if (state == MUTEX_FREE)
+    return;
+
+  /* Mark M contended before waiting, so that its holder knows to
+     wake us.  Once we own it that way, we cannot tell whether
+     anyone else is still waiting, so keep it marked contended and
+     let the next release make a possibly useless futex_wake(). */
+  if (state != MUTEX_CONTENDED)
+    state = xchg (&m->state, MUTEX_CONTENDED);
+  while (state != MUTEX_FREE) 
+    {
+      futex_wait ((int *) &m->state, MUTEX_CONTENDED);
+      state = xchg (&m->state, MUTEX_CONTENDED);
+    }
+}
+
+/* Tries to acquire M without waiting.  Returns true if
+   successful, false if M was already held. */
+bool
+mutex_trylock (struct mutex *m) 
+{
+  ASSERT (m != NULL);
+  return cmpxchg (&m->state, MUTEX_FREE, MUTEX_HELD) == MUTEX_FREE;
+}
+
+/* Releases M, which the caller must hold, and wakes one thread
+   waiting for it, if any. */
+void
+mutex_unlock (struct mutex *m) 
+{
+  int state;
+
+  ASSERT (m != NULL);
+
+  state = xchg (&m->state, MUTEX_FREE);
+  ASSERT (state != MUTEX_FREE);
+  if (state == MUTEX_CONTENDED)
+    futex_wake ((int *) &m->state, 1);
+}
@@ -0,0 +1,30 @@
+#ifndef __LIB_USER_MUTEX_H
+#define __LIB_USER_MUTEX_H
+
+#include <stdbool.h>
+
+/* Mutual exclusion lock for user programs.
+
+   Acquiring a free mutex or releasing one that nobody is waiting
+   for takes a single atomic instruction and no system call.  Only
+   a thread that finds the mutex held calls futex_wait(), and only
+   a release that may have waiters calls futex_wake(). */
+struct mutex 
+  {
+    volatile int state;         /* MUTEX_FREE, _HELD, or _CONTENDED. */
+  };
+
+/* Mutex states. */
+#define MUTEX_FREE 0            /* Not held. */
+#define MUTEX_HELD 1            /* Held, nobody waiting. */
+#define MUTEX_CONTENDED 2       /* Held, others may be waiting. */
+
+/* Initializer for a free mutex. */
+#define MUTEX_INITIALIZER { MUTEX_FREE }
+
+void mutex_init (struct mutex *);
+void mutex_lock (struct mutex *);
+bool mutex_trylock (struct mutex *);
+void mutex_unlock (struct mutex *);
+
+#endif /* lib/user/mutex.h */
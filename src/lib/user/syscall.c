@@ -182,3 +182,49 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+int
+futex_wait (int *addr, int expected) 
+{
+  return syscall2 (SYS_FUTEX_WAIT, addr, expected);
+}
+
+int
+futex_wake (int *addr, int n) 
+{
+  return syscall2 (SYS_FUTEX_WAKE, addr, n);
+}
+
+/* First code run by a thread started by thread_create(), which
+   the kernel calls as thread_entry (FN, AUX). */
+static void
+thread_entry (thread_func *fn, void *aux) 
+{
+  fn (aux);
+  thread_exit ();
+}
+
+tid_t
+thread_create (thread_func *fn, void *aux) 
+{
+  return syscall3 (SYS_THREAD_CREATE, thread_entry, fn, aux);
+}
+
+void
+thread_exit (void) 
+{
+  syscall0 (SYS_THREAD_EXIT);
+  NOT_REACHED ();
+}
+
+int
+thread_join (tid_t tid) 
+{
+  return syscall1 (SYS_THREAD_JOIN, tid);
+}
+
+bool
+getrusage (pid_t who, struct rusage *usage) 
+{
+  return syscall2 (SYS_GETRUSAGE, who, usage);
+}
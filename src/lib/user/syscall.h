@@ -3,11 +3,19 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <rusage.h>
 
 /* Process identifier. */
 typedef int pid_t;
 #define PID_ERROR ((pid_t) -1)
 
+/* Thread identifier. */
+typedef int tid_t;
+#define TID_ERROR ((tid_t) -1)
+
+/* Function run by a thread started with thread_create(). */
+typedef void thread_func (void *aux);
+
 /* Map region identifier. */
 typedef int mapid_t;
 #define MAP_FAILED ((mapid_t) -1)
@@ -45,4 +53,12 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+int futex_wait (int *addr, int expected);
+int futex_wake (int *addr, int n);
+tid_t thread_create (thread_func *, void *aux);
+void thread_exit (void) NO_RETURN;
+int thread_join (tid_t);
+bool getrusage (pid_t who, struct rusage *usage);
+
 #endif /* lib/user/syscall.h */
@@ -0,0 +1,83 @@
+/* Checks object caches.  Objects come back aligned, distinct and
+   constructed, the constructor runs once per object rather than
+   once per allocation, and freed objects are handed out again. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/kmem.h"
+
+#define OBJ_CNT 300
+#define CONSTRUCTED 0x600dc0de
+
+struct object
+  {
+    int state;
+    char pad[15];
+  };
+
+static int ctor_cnt;
+
+static void
+construct (void *obj_) 
+{
+  struct object *obj = obj_;
+  obj->state = CONSTRUCTED;
+  ctor_cnt++;
+}
+
+static struct kmem_cache cache =
+  KMEM_CACHE_INITIALIZER ("kmem-cache test", sizeof (struct object), 16,
+                          construct);
+
+void
+test_kmem_cache (void) 
+{
+  static struct object *objs[OBJ_CNT];
+  int first_ctor_cnt;
+  int i, j;
+
+  for (i = 0; i < OBJ_CNT; i++) 
+    {
+      objs[i] = kmem_cache_alloc (&cache);
+      ASSERT (objs[i] != NULL);
+      if ((uintptr_t) objs[i] % 16 != 0)
+        fail ("object %d at %p is not 16-byte aligned", i, objs[i]);
+      if (objs[i]->state != CONSTRUCTED)
+        fail ("object %d is not constructed", i);
+      objs[i]->state = i;
+      for (j = 0; j < i; j++)
+        if (objs[j] == objs[i])
+          fail ("objects %d and %d are both %p", j, i, objs[i]);
+    }
+  msg ("allocated %d aligned, constructed, distinct objects", OBJ_CNT);
+
+  for (i = 0; i < OBJ_CNT; i++)
+    if (objs[i]->state != i)
+      fail ("object %d was overwritten", i);
+  msg ("no object overlaps another");
+
+  /* Objects must be freed in their constructed state. */
+  first_ctor_cnt = ctor_cnt;
+  for (i = 0; i < OBJ_CNT; i++) 
+    {
+      objs[i]->state = CONSTRUCTED;
+      kmem_cache_free (&cache, objs[i]);
+    }
+  for (i = 0; i < OBJ_CNT; i++) 
+    {
+      objs[i] = kmem_cache_alloc (&cache);
+      ASSERT (objs[i] != NULL);
+      if (objs[i]->state != CONSTRUCTED)
+        fail ("reused object %d is not constructed", i);
+    }
+  if (ctor_cnt > first_ctor_cnt + OBJ_CNT / 2)
+    fail ("constructor ran %d more times to reallocate %d objects",
+          ctor_cnt - first_ctor_cnt, OBJ_CNT);
+  msg ("freed objects reused without reconstruction");
+
+  for (i = 0; i < OBJ_CNT; i++)
+    kmem_cache_free (&cache, objs[i]);
+  msg ("freed all objects");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(kmem-cache) begin
+(kmem-cache) allocated 300 aligned, constructed, distinct objects
+(kmem-cache) no object overlaps another
+(kmem-cache) freed objects reused without reconstruction
+(kmem-cache) freed all objects
+(kmem-cache) end
+EOF
+pass;
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(mlfqs-block-long) begin
+(mlfqs-block-long) Main thread acquiring lock.
+(mlfqs-block-long) Main thread creating block thread, sleeping 85 seconds...
+(mlfqs-block-long) Block thread spinning for 20 seconds...
+(mlfqs-block-long) Block thread acquiring lock...
+(mlfqs-block-long) Main thread spinning for 5 seconds...
+(mlfqs-block-long) Main thread releasing lock.
+(mlfqs-block-long) ...got it.
+(mlfqs-block-long) Block thread should have already acquired lock.
+(mlfqs-block-long) end
+EOF
+pass;
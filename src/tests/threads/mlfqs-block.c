@@ -7,7 +7,12 @@
    seconds (until the main thread releases it).  If recent_cpu
    decays properly while the "block" thread sleeps, then the
    block thread should be immediately scheduled when the main
-   thread releases the lock. */
+   thread releases the lock.
+
+   mlfqs-block-long does the same, but the main thread sleeps
+   for 85 seconds, so that the "block" thread stays blocked for
+   more decay passes than the scheduler keeps coefficients for
+   (64).  Its recent_cpu must still have decayed when it wakes. */
 
 #include <stdio.h>
 #include "tests/threads/tests.h"
@@ -17,10 +22,23 @@
 #include "threads/thread.h"
 #include "devices/timer.h"
 
+static void test_block (int sleep_seconds);
 static void block_thread (void *lock_);
 
 void
 test_mlfqs_block (void) 
+{
+  test_block (25);
+}
+
+void
+test_mlfqs_block_long (void) 
+{
+  test_block (85);
+}
+
+static void
+test_block (int sleep_seconds) 
 {
   int64_t start_time;
   struct lock lock;
@@ -31,9 +49,10 @@ test_mlfqs_block (void)
   lock_init (&lock);
   lock_acquire (&lock);
   
-  msg ("Main thread creating block thread, sleeping 25 seconds...");
-  thread_create ("block", PRI_DEFAULT, block_thread, &lock);
-  timer_sleep (25 * TIMER_FREQ);
+  msg ("Main thread creating block thread, sleeping %d seconds...",
+       sleep_seconds);
+  thread_create ("block", PRI_DEFAULT, block_thread, &lock, NULL);
+  timer_sleep (sleep_seconds * TIMER_FREQ);
 
   msg ("Main thread spinning for 5 seconds...");
   start_time = timer_ticks ();
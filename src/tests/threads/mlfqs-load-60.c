@@ -124,7 +124,7 @@ test_mlfqs_load_60 (void)
     {
       char name[16];
       snprintf(name, sizeof name, "load %d", i);
-      thread_create (name, PRI_DEFAULT, load_thread, NULL);
+      thread_create (name, PRI_DEFAULT, load_thread, NULL, NULL);
     }
   msg ("Starting threads took %d seconds.",
        timer_elapsed (start_time) / TIMER_FREQ);
@@ -135,7 +135,7 @@ test_mlfqs_load_avg (void)
     {
       char name[16];
       snprintf(name, sizeof name, "load %d", i);
-      thread_create (name, PRI_DEFAULT, load_thread, (void *) i);
+      thread_create (name, PRI_DEFAULT, load_thread, (void *) i, NULL);
     }
   msg ("Starting threads took %d seconds.",
        timer_elapsed (start_time) / TIMER_FREQ);
@@ -0,0 +1,97 @@
+/* Compares the cost of locks that use priority donation with
+   that of locks that use a priority ceiling.
+
+   First, the main thread acquires and releases the lock many
+   times with no other thread interested.  Then it hands the lock
+   back and forth with a thread of higher priority: each time the
+   main thread holds the lock, it wakes the other thread, which
+   then acquires and releases the lock in turn.  With donation,
+   the other thread runs at once, blocks on the lock, and donates
+   its priority until the main thread releases it.  With a ceiling
+   of the other thread's priority, the main thread keeps running
+   until it releases the lock, so the other thread finds it free.
+
+   The costs are reported in CPU cycles per iteration, so they
+   vary from run to run and machine to machine. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/tsc.h"
+
+#define ITERATIONS 1000
+
+struct handoff 
+  {
+    struct lock *lock;
+    struct semaphore go;
+  };
+
+static void bench (const char *kind, struct lock *);
+static thread_func handoff_thread_func;
+
+void
+test_priority_ceiling_bench (void) 
+{
+  struct lock donation, ceiling;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  lock_init (&donation);
+  lock_init_ceiling (&ceiling, PRI_DEFAULT + 1);
+  bench ("donation", &donation);
+  bench ("ceiling", &ceiling);
+}
+
+/* Times LOCK, reporting the results under KIND. */
+static void
+bench (const char *kind, struct lock *lock) 
+{
+  struct handoff h;
+  uint64_t start;
+  int i;
+
+  start = rdtsc ();
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      lock_acquire (lock);
+      lock_release (lock);
+    }
+  msg ("%s: %"PRIu64" cycles per uncontended acquire and release.",
+       kind, (rdtsc () - start) / ITERATIONS);
+
+  h.lock = lock;
+  sema_init (&h.go, 0);
+  thread_create ("handoff", PRI_DEFAULT + 1, handoff_thread_func, &h, NULL);
+
+  start = rdtsc ();
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      lock_acquire (lock);
+      sema_up (&h.go);
+      lock_release (lock);
+    }
+  msg ("%s: %"PRIu64" cycles per handoff to a higher-priority thread.",
+       kind, (rdtsc () - start) / ITERATIONS);
+}
+
+static void
+handoff_thread_func (void *h_) 
+{
+  struct handoff *h = h_;
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      sema_down (&h->go);
+      lock_acquire (h->lock);
+      lock_release (h->lock);
+    }
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+foreach my $kind ("donation", "ceiling") {
+    fail "No uncontended timing for $kind locks.\n"
+      if !grep (/\) $kind: \d+ cycles per uncontended/, @output);
+    fail "No handoff timing for $kind locks.\n"
+      if !grep (/\) $kind: \d+ cycles per handoff/, @output);
+}
+pass;
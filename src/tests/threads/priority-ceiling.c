@@ -0,0 +1,42 @@
+/* The main thread acquires a lock with a priority ceiling above
+   its own priority, which raises it to the ceiling at once.  A
+   thread of medium priority, between the two, is created while
+   the lock is held and must not run until the lock is released,
+   and then must run right away. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func medium_thread_func;
+
+void
+test_priority_ceiling (void) 
+{
+  struct lock lock;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  lock_init_ceiling (&lock, PRI_DEFAULT + 10);
+  lock_acquire (&lock);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 10, thread_get_priority ());
+  thread_create ("medium", PRI_DEFAULT + 5, medium_thread_func, NULL, NULL);
+  msg ("medium must not have run yet.");
+  lock_release (&lock);
+  msg ("medium must already have run.");
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+medium_thread_func (void *aux UNUSED) 
+{
+  msg ("medium: running");
+}
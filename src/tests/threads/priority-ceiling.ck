@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-ceiling) begin
+(priority-ceiling) This thread should have priority 41.  Actual priority: 41.
+(priority-ceiling) medium must not have run yet.
+(priority-ceiling) medium: running
+(priority-ceiling) medium must already have run.
+(priority-ceiling) This thread should have priority 31.  Actual priority: 31.
+(priority-ceiling) end
+EOF
+pass;
@@ -0,0 +1,78 @@
+/* Thread L holds a lock that higher-priority thread H donates
+   to.  L then waits on a condition variable, which releases the
+   lock and so the donation, while thread A, of a priority between
+   L's own and the donated one, is already waiting on the same
+   condition.  A signal must wake A first, because L's place in
+   the condition's queue has to follow its priority back down. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static struct lock lock;
+static struct condition condition;
+static struct semaphore go;
+
+static thread_func a_thread_func;
+static thread_func l_thread_func;
+static thread_func h_thread_func;
+
+void
+test_priority_donate_condvar (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  lock_init (&lock);
+  cond_init (&condition);
+  sema_init (&go, 0);
+
+  thread_create ("a", PRI_DEFAULT + 4, a_thread_func, NULL, NULL);
+  thread_create ("l", PRI_DEFAULT + 2, l_thread_func, NULL, NULL);
+  thread_create ("h", PRI_DEFAULT + 9, h_thread_func, NULL, NULL);
+  sema_up (&go);
+
+  lock_acquire (&lock);
+  cond_signal (&condition, &lock);
+  lock_release (&lock);
+
+  lock_acquire (&lock);
+  cond_signal (&condition, &lock);
+  lock_release (&lock);
+}
+
+static void
+a_thread_func (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  msg ("a: waiting");
+  cond_wait (&condition, &lock);
+  msg ("a: woke up");
+  lock_release (&lock);
+}
+
+static void
+l_thread_func (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  msg ("l: holding the lock");
+  sema_down (&go);
+  msg ("l: should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 9, thread_get_priority ());
+  cond_wait (&condition, &lock);
+  msg ("l: woke up with priority %d", thread_get_priority ());
+  lock_release (&lock);
+}
+
+static void
+h_thread_func (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  msg ("h: got the lock");
+  lock_release (&lock);
+}
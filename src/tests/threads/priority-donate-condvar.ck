@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-donate-condvar) begin
+(priority-donate-condvar) a: waiting
+(priority-donate-condvar) l: holding the lock
+(priority-donate-condvar) l: should have priority 40.  Actual priority: 40.
+(priority-donate-condvar) h: got the lock
+(priority-donate-condvar) a: woke up
+(priority-donate-condvar) l: woke up with priority 33
+(priority-donate-condvar) end
+EOF
+pass;
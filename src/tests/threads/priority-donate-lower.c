@@ -25,7 +25,8 @@ test_priority_donate_lower (void)
 
   lock_init (&lock);
   lock_acquire (&lock);
-  thread_create ("acquire", PRI_DEFAULT + 10, acquire_thread_func, &lock);
+  thread_create ("acquire", PRI_DEFAULT + 10, acquire_thread_func, &lock,
+                 NULL);
   msg ("Main thread should have priority %d.  Actual priority: %d.",
        PRI_DEFAULT + 10, thread_get_priority ());
 
@@ -27,7 +27,7 @@ test_priority_sema (void)
       int priority = PRI_DEFAULT - (i + 3) % 10 - 1;
       char name[16];
       snprintf (name, sizeof name, "priority %d", priority);
-      thread_create (name, priority, priority_sema_thread, NULL);
+      thread_create (name, priority, priority_sema_thread, NULL, NULL);
     }
 
   for (i = 0; i < 10; i++) 
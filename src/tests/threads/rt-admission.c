@@ -0,0 +1,84 @@
+/* Checks admission control of the real-time scheduling class.
+   Reservations are admitted only while the sum of budget /
+   deadline over all of them stays within 95%, a reservation is
+   released when its thread exits or clears it, and a thread that
+   asks again replaces its own reservation rather than adding to
+   it. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define MAX_RESERVATIONS 3
+
+struct reservation 
+  {
+    int64_t period;
+    int64_t budget;
+    int64_t deadline;
+  };
+
+struct child 
+  {
+    const char *name;
+    struct reservation reservations[MAX_RESERVATIONS];
+    int reservation_cnt;
+  };
+
+static struct semaphore child_done;
+
+static void try_reserve (const char *name, const struct reservation *);
+static void run_child (struct child *);
+static thread_func child_thread;
+
+void
+test_rt_admission (void) 
+{
+  static const struct reservation main_rsv = {100, 50, 100};
+  struct child a = {"a", {{20, 10, 20}, {20, 8, 20}}, 2};
+  struct child b = {"b", {{20, 8, 20}}, 1};
+  struct child c = {"c", {{100, 10, 20}}, 1};
+  struct child d = {"d", {{100, 90, 100}, {100, 96, 100}, {100, 95, 100}}, 3};
+
+  try_reserve ("main", &main_rsv);
+  run_child (&a);
+  run_child (&b);
+  run_child (&c);
+  thread_clear_realtime ();
+  msg ("main: reservation cleared");
+  run_child (&d);
+}
+
+/* Asks for reservation R for the running thread, called NAME,
+   and reports the outcome. */
+static void
+try_reserve (const char *name, const struct reservation *r) 
+{
+  bool admitted = thread_set_realtime (r->period, r->budget, r->deadline);
+  msg ("%s: period %"PRId64", budget %"PRId64", deadline %"PRId64": %s",
+       name, r->period, r->budget, r->deadline,
+       admitted ? "admitted" : "rejected");
+}
+
+/* Runs CHILD in a thread of its own and waits until it is done. */
+static void
+run_child (struct child *child) 
+{
+  sema_init (&child_done, 0);
+  thread_create (child->name, PRI_DEFAULT, child_thread, child, NULL);
+  sema_down (&child_done);
+}
+
+static void
+child_thread (void *child_) 
+{
+  struct child *child = child_;
+  int i;
+
+  for (i = 0; i < child->reservation_cnt; i++)
+    try_reserve (child->name, &child->reservations[i]);
+  sema_up (&child_done);
+}
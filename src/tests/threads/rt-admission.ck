@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rt-admission) begin
+(rt-admission) main: period 100, budget 50, deadline 100: admitted
+(rt-admission) a: period 20, budget 10, deadline 20: rejected
+(rt-admission) a: period 20, budget 8, deadline 20: admitted
+(rt-admission) b: period 20, budget 8, deadline 20: admitted
+(rt-admission) c: period 100, budget 10, deadline 20: rejected
+(rt-admission) main: reservation cleared
+(rt-admission) d: period 100, budget 90, deadline 100: admitted
+(rt-admission) d: period 100, budget 96, deadline 100: rejected
+(rt-admission) d: period 100, budget 95, deadline 100: admitted
+(rt-admission) end
+EOF
+pass;
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rt-edf-load) begin
+(rt-edf-load) Running 3 real-time threads against 4 CPU hogs...
+(rt-edf-load) rt 10: 0 of 24 deadlines missed.
+(rt-edf-load) rt 20: 0 of 12 deadlines missed.
+(rt-edf-load) rt 40: 0 of 6 deadlines missed.
+(rt-edf-load) end
+EOF
+pass;
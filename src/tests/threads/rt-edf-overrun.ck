@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rt-edf-overrun) begin
+(rt-edf-overrun) Running 3 real-time threads against 2 CPU hogs...
+(rt-edf-overrun) rt 10: 0 of 20 deadlines missed.
+(rt-edf-overrun) rt 20: 0 of 10 deadlines missed.
+(rt-edf-overrun) overrun: overran its budget and missed some deadlines.
+(rt-edf-overrun) end
+EOF
+pass;
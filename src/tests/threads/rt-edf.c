@@ -0,0 +1,173 @@
+/* Measures deadline misses of periodic real-time threads that
+   share the CPU with busy background threads.
+
+   In rt-edf-load, three real-time threads with a total density
+   of 77.5% run against CPU hogs of the highest normal priority.
+   Real-time threads always run ahead of normal ones, in
+   earliest-deadline-first order, so none of them should miss a
+   deadline.
+
+   In rt-edf-overrun, one of the real-time threads asks for a
+   budget of 2 ticks per 10 but actually uses 8.  Budget
+   enforcement demotes it to the normal class for the rest of
+   each job, so it misses its own deadlines but the others still
+   meet all of theirs. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+struct rt_task 
+  {
+    const char *name;
+    int64_t period;             /* Ticks between releases. */
+    int64_t budget;             /* Ticks reserved per job. */
+    int work;                   /* Ticks each job actually uses. */
+    int job_cnt;                /* Number of jobs to run. */
+  };
+
+#define MAX_TASK_CNT 3
+
+struct rt_info 
+  {
+    const struct rt_task *task;
+    unsigned misses;            /* Deadlines missed. */
+    struct semaphore started;
+    struct semaphore done;
+  };
+
+static void run_rt_tasks (const struct rt_task *, int task_cnt,
+                          int hog_cnt, int hog_priority);
+
+void
+test_rt_edf_load (void) 
+{
+  static const struct rt_task tasks[] = 
+    {
+      {"rt 10", 10, 3, 2, 24},
+      {"rt 20", 20, 5, 4, 12},
+      {"rt 40", 40, 9, 8, 6},
+    };
+
+  run_rt_tasks (tasks, 3, 4, PRI_MAX);
+}
+
+void
+test_rt_edf_overrun (void) 
+{
+  static const struct rt_task tasks[] = 
+    {
+      {"rt 10", 10, 4, 3, 20},
+      {"rt 20", 20, 6, 5, 10},
+      {"overrun", 10, 2, 8, 10},
+    };
+
+  run_rt_tasks (tasks, 3, 2, PRI_DEFAULT);
+}
+
+static int task_cnt;
+static volatile int done_cnt;
+
+static thread_func rt_thread;
+static thread_func hog_thread;
+
+/* Runs each of the TASK_CNT TASKS in a real-time thread of its
+   own, alongside HOG_CNT threads of priority HOG_PRIORITY that
+   spin until the tasks are done, then reports their misses. */
+static void
+run_rt_tasks (const struct rt_task *tasks, int task_cnt_,
+              int hog_cnt, int hog_priority) 
+{
+  struct rt_info info[MAX_TASK_CNT];
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+  ASSERT (task_cnt_ <= MAX_TASK_CNT);
+
+  /* Outrank the hogs until everything has been started. */
+  thread_set_priority (PRI_MAX);
+
+  task_cnt = task_cnt_;
+  done_cnt = 0;
+  for (i = 0; i < task_cnt; i++) 
+    {
+      struct rt_info *ri = &info[i];
+
+      ri->task = &tasks[i];
+      ri->misses = 0;
+      sema_init (&ri->started, 0);
+      sema_init (&ri->done, 0);
+      thread_create (tasks[i].name, PRI_DEFAULT, rt_thread, ri, NULL);
+      sema_down (&ri->started);
+    }
+
+  msg ("Running %d real-time threads against %d CPU hogs...",
+       task_cnt, hog_cnt);
+  for (i = 0; i < hog_cnt; i++)
+    thread_create ("hog", hog_priority, hog_thread, NULL, NULL);
+
+  for (i = 0; i < task_cnt; i++)
+    sema_down (&info[i].done);
+
+  for (i = 0; i < task_cnt; i++) 
+    {
+      const struct rt_task *task = &tasks[i];
+
+      if (task->work > task->budget)
+        msg ("%s: overran its budget and missed %s deadlines.",
+             task->name, info[i].misses > 0 ? "some" : "no");
+      else
+        msg ("%s: %u of %d deadlines missed.",
+             task->name, info[i].misses, task->job_cnt);
+    }
+}
+
+/* Busy-waits until the timer has ticked TICK_CNT times while this
+   thread was running. */
+static void
+spin_ticks (int tick_cnt) 
+{
+  int64_t last_time = timer_ticks ();
+
+  while (tick_cnt > 0) 
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        tick_cnt--;
+      last_time = cur_time;
+    }
+}
+
+static void
+rt_thread (void *ri_) 
+{
+  struct rt_info *ri = ri_;
+  const struct rt_task *task = ri->task;
+  unsigned jobs;
+  int i;
+
+  if (!thread_set_realtime (task->period, task->budget, task->period))
+    fail ("%s: reservation rejected", task->name);
+  sema_up (&ri->started);
+
+  for (i = 0; i < task->job_cnt; i++) 
+    {
+      spin_ticks (task->work);
+      thread_wait_next_period ();
+    }
+  thread_get_rt_stats (&jobs, &ri->misses);
+
+  done_cnt++;
+  sema_up (&ri->done);
+}
+
+static void
+hog_thread (void *aux UNUSED) 
+{
+  while (done_cnt < task_cnt)
+    continue;
+}
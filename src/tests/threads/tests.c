@@ -25,6 +25,10 @@ static const struct test tests[] =
     {"priority-donate-sema", test_priority_donate_sema},
     {"priority-donate-lower", test_priority_donate_lower},
     {"priority-donate-chain", test_priority_donate_chain},
+    {"priority-donate-rwlock", test_priority_donate_rwlock},
+    {"priority-donate-condvar", test_priority_donate_condvar},
+    {"priority-ceiling", test_priority_ceiling},
+    {"priority-ceiling-bench", test_priority_ceiling_bench},
     {"priority-fifo", test_priority_fifo},
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
@@ -38,6 +42,16 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"mlfqs-block-long", test_mlfqs_block_long},
+    {"cfs-fair-2", test_cfs_fair_2},
+    {"cfs-fair-20", test_cfs_fair_20},
+    {"cfs-nice-2", test_cfs_nice_2},
+    {"cfs-nice-10", test_cfs_nice_10},
+    {"rt-admission", test_rt_admission},
+    {"rt-edf-load", test_rt_edf_load},
+    {"rt-edf-overrun", test_rt_edf_overrun},
+    {"workqueue", test_workqueue},
+    {"kmem-cache", test_kmem_cache},
   };
 
 static const char *test_name;
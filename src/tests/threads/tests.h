@@ -19,6 +19,10 @@ extern test_func test_priority_donate_sema;
 extern test_func test_priority_donate_nest;
 extern test_func test_priority_donate_lower;
 extern test_func test_priority_donate_chain;
+extern test_func test_priority_donate_rwlock;
+extern test_func test_priority_donate_condvar;
+extern test_func test_priority_ceiling;
+extern test_func test_priority_ceiling_bench;
 extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
@@ -32,6 +36,16 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_mlfqs_block_long;
+extern test_func test_cfs_fair_2;
+extern test_func test_cfs_fair_20;
+extern test_func test_cfs_nice_2;
+extern test_func test_cfs_nice_10;
+extern test_func test_rt_admission;
+extern test_func test_rt_edf_load;
+extern test_func test_rt_edf_overrun;
+extern test_func test_workqueue;
+extern test_func test_kmem_cache;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
@@ -0,0 +1,83 @@
+/* Checks the deferred work queue.  Work items run in the worker
+   thread with interrupts on, an item may queue itself again from
+   its own function, and an item queued again before it has
+   started runs only once. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+
+static struct semaphore done;
+static struct semaphore gate;
+static int chain_runs;
+static int coalesced_runs;
+
+static work_func simple_func, chain_func, blocker_func, coalesced_func;
+
+void
+test_workqueue (void) 
+{
+  static struct work simple, chain, blocker, coalesced;
+  bool first, second;
+
+  sema_init (&done, 0);
+  sema_init (&gate, 0);
+  work_init (&simple, simple_func);
+  work_init (&chain, chain_func);
+  work_init (&blocker, blocker_func);
+  work_init (&coalesced, coalesced_func);
+
+  work_queue (&simple);
+  sema_down (&done);
+
+  work_queue (&chain);
+  sema_down (&done);
+
+  /* Keep the worker busy so that the next item stays queued. */
+  work_queue (&blocker);
+  first = work_queue (&coalesced);
+  second = work_queue (&coalesced);
+  msg ("queued twice: %s, then %s",
+       first ? "queued" : "coalesced", second ? "queued" : "coalesced");
+  sema_up (&gate);
+  sema_down (&done);
+  msg ("coalesced item ran %d time(s)", coalesced_runs);
+}
+
+static void
+simple_func (struct work *w UNUSED) 
+{
+  msg ("simple: ran in \"%s\" with interrupts %s", thread_name (),
+       intr_get_level () == INTR_ON ? "on" : "off");
+  sema_up (&done);
+}
+
+static void
+chain_func (struct work *w) 
+{
+  msg ("chain: run %d", ++chain_runs);
+  if (chain_runs < 3)
+    work_queue (w);
+  else
+    sema_up (&done);
+}
+
+static void
+blocker_func (struct work *w UNUSED) 
+{
+  msg ("blocker: waiting");
+  sema_down (&gate);
+  msg ("blocker: released");
+}
+
+static void
+coalesced_func (struct work *w UNUSED) 
+{
+  coalesced_runs++;
+  sema_up (&done);
+}
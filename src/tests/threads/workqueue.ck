@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workqueue) begin
+(workqueue) simple: ran in "worker" with interrupts on
+(workqueue) chain: run 1
+(workqueue) chain: run 2
+(workqueue) chain: run 3
+(workqueue) blocker: waiting
+(workqueue) queued twice: queued, then coalesced
+(workqueue) blocker: released
+(workqueue) coalesced item ran 1 time(s)
+(workqueue) end
+EOF
+pass;
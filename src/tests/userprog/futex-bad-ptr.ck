@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF', <<'EOF']);
+(futex-bad-ptr) begin
+(futex-bad-ptr) end
+futex-bad-ptr: exit(0)
+EOF
+(futex-bad-ptr) begin
+futex-bad-ptr: exit(-1)
+EOF
+pass;
@@ -0,0 +1,27 @@
+/* Exercises the futex system calls and the user-level mutex in a
+   single thread.  futex_wait() must return at once when the word
+   no longer holds the expected value, futex_wake() on a word
+   nobody waits on must wake nobody, and an uncontended mutex must
+   go back to its free state after each release. */
+
+#include <mutex.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  static struct mutex m = MUTEX_INITIALIZER;
+  static int word = 5;
+
+  CHECK (futex_wait (&word, 4) == -1, "futex_wait on changed word");
+  CHECK (futex_wake (&word, 1) == 0, "futex_wake with no waiters");
+
+  CHECK (mutex_trylock (&m), "trylock free mutex");
+  CHECK (!mutex_trylock (&m), "trylock held mutex");
+  mutex_unlock (&m);
+  mutex_lock (&m);
+  mutex_unlock (&m);
+  CHECK (m.state == MUTEX_FREE, "mutex free after unlock");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-simple) begin
+(futex-simple) futex_wait on changed word
+(futex-simple) futex_wake with no waiters
+(futex-simple) trylock free mutex
+(futex-simple) trylock held mutex
+(futex-simple) mutex free after unlock
+(futex-simple) end
+futex-simple: exit(0)
+EOF
+pass;
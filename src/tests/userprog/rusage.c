@@ -0,0 +1,58 @@
+/* Checks the getrusage system call.  CPU time spent computing in
+   user mode is charged to the calling thread, a process's usage
+   covers all of its threads, including those that have exited,
+   and asking about a process that does not exist fails. */
+
+#include <rusage.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Spins in user mode until the calling thread has been charged
+   with at least TICKS user ticks, and returns its usage then. */
+static struct rusage
+spin_for (int64_t ticks) 
+{
+  struct rusage usage;
+
+  do 
+    {
+      volatile int i;
+      for (i = 0; i < 100000; i++)
+        continue;
+      if (!getrusage (RUSAGE_THREAD, &usage))
+        fail ("getrusage (RUSAGE_THREAD) failed");
+    }
+  while (usage.user_ticks < ticks);
+  return usage;
+}
+
+static struct rusage spinner_usage;
+
+static void
+spinner (void *aux UNUSED) 
+{
+  spinner_usage = spin_for (5);
+}
+
+void
+test_main (void) 
+{
+  struct rusage self, process;
+  tid_t tid;
+
+  self = spin_for (3);
+  msg ("thread charged with user ticks");
+
+  CHECK ((tid = thread_create (spinner, NULL)) != TID_ERROR,
+         "create spinner");
+  CHECK (thread_join (tid) == 0, "join spinner");
+
+  CHECK (getrusage (RUSAGE_SELF, &process), "getrusage (RUSAGE_SELF)");
+  if (process.user_ticks < self.user_ticks + spinner_usage.user_ticks)
+    fail ("process has %lld user ticks, threads had %lld and %lld",
+          process.user_ticks, self.user_ticks, spinner_usage.user_ticks);
+  msg ("process includes exited thread");
+
+  CHECK (!getrusage (0x7fffffff, &process), "getrusage of no such process");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rusage) begin
+(rusage) thread charged with user ticks
+(rusage) create spinner
+(rusage) join spinner
+(rusage) getrusage (RUSAGE_SELF)
+(rusage) process includes exited thread
+(rusage) getrusage of no such process
+(rusage) end
+rusage: exit(0)
+EOF
+pass;
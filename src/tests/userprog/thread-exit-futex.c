@@ -0,0 +1,30 @@
+/* Has the first thread call exit() while another thread is
+   blocked in futex_wait() on a word that nobody will ever wake.
+   The exit must wake that thread and end it, or the process never
+   finishes exiting and the test times out. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Set by the waiter just before it waits. */
+static volatile bool waiting;
+
+static void
+waiter (void *aux UNUSED) 
+{
+  static int word;
+
+  waiting = true;
+  futex_wait (&word, 0);
+  fail ("waiter woke up in user mode");
+}
+
+void
+test_main (void) 
+{
+  CHECK (thread_create (waiter, NULL) != TID_ERROR, "create waiter");
+  while (!waiting)
+    continue;
+  exit (23);
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(thread-exit-futex) begin
+(thread-exit-futex) create waiter
+thread-exit-futex: exit(23)
+EOF
+pass;
@@ -0,0 +1,38 @@
+/* Has a thread other than the first call exit().  That must end
+   the whole process with the status it passed, including the
+   first thread, which is blocked joining a thread that never
+   finishes on its own. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Set once the first thread has reported its progress. */
+static volatile bool go;
+
+static void
+spin (void *aux UNUSED) 
+{
+  for (;;)
+    continue;
+}
+
+static void
+exiter (void *aux UNUSED) 
+{
+  while (!go)
+    continue;
+  exit (57);
+}
+
+void
+test_main (void) 
+{
+  tid_t spinner = thread_create (spin, NULL);
+
+  CHECK (spinner != TID_ERROR, "create spinner");
+  CHECK (thread_create (exiter, NULL) != TID_ERROR, "create exiter");
+  go = true;
+  thread_join (spinner);
+  fail ("should have exited with status 57");
+}
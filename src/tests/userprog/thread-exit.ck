@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(thread-exit) begin
+(thread-exit) create spinner
+(thread-exit) create exiter
+thread-exit: exit(57)
+EOF
+pass;
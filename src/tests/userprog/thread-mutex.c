@@ -0,0 +1,64 @@
+/* Has several threads of this process increment a shared counter
+   under a mutex, long enough that timer interrupts preempt them
+   inside the critical section, so that the mutex is contended
+   and its futex path is exercised.  Then checks that a file
+   opened by one thread can be used by another through its fd. */
+
+#include <mutex.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define ITERATIONS 20000
+
+static struct mutex counter_mutex = MUTEX_INITIALIZER;
+static volatile int counter;
+static int fd;
+
+static void
+increment (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      int old;
+
+      mutex_lock (&counter_mutex);
+      old = counter;
+      /* Widen the window for a preemption to land in. */
+      asm volatile ("" : : : "memory");
+      counter = old + 1;
+      mutex_unlock (&counter_mutex);
+    }
+}
+
+static void
+open_file (void *aux UNUSED) 
+{
+  fd = open ("sample.txt");
+}
+
+void
+test_main (void) 
+{
+  tid_t tids[THREAD_CNT];
+  tid_t opener;
+  int i;
+
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK ((tids[i] = thread_create (increment, NULL)) != TID_ERROR,
+           "create thread %d", i);
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK (thread_join (tids[i]) == 0, "join thread %d", i);
+  if (counter != THREAD_CNT * ITERATIONS)
+    fail ("counter is %d, expected %d", counter, THREAD_CNT * ITERATIONS);
+  msg ("counter correct");
+
+  CHECK ((opener = thread_create (open_file, NULL)) != TID_ERROR,
+         "create opener");
+  CHECK (thread_join (opener) == 0, "join opener");
+  CHECK (fd > 1, "opener got an fd");
+  CHECK (filesize (fd) > 0, "filesize on opener's fd");
+}
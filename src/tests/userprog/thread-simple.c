@@ -0,0 +1,51 @@
+/* Starts several threads in this process, each summing its own
+   part of an array into a shared result table, and joins them.
+   Also checks that a thread can be joined only once, and that
+   the caller and unknown tids cannot be joined at all. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define PART_SIZE 256
+
+static int values[THREAD_CNT * PART_SIZE];
+static int sums[THREAD_CNT];
+
+static void
+sum_part (void *part_) 
+{
+  int part = (int) part_;
+  int i;
+
+  for (i = 0; i < PART_SIZE; i++)
+    sums[part] += values[part * PART_SIZE + i];
+}
+
+void
+test_main (void) 
+{
+  tid_t tids[THREAD_CNT];
+  int i;
+
+  for (i = 0; i < THREAD_CNT * PART_SIZE; i++)
+    values[i] = i;
+
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK ((tids[i] = thread_create (sum_part, (void *) i)) != TID_ERROR,
+           "create thread %d", i);
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK (thread_join (tids[i]) == 0, "join thread %d", i);
+
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      int expected = PART_SIZE * (2 * i * PART_SIZE + PART_SIZE - 1) / 2;
+      if (sums[i] != expected)
+        fail ("part %d sums to %d, expected %d", i, sums[i], expected);
+    }
+  msg ("sums correct");
+
+  CHECK (thread_join (tids[0]) == -1, "join thread 0 again");
+  CHECK (thread_join (tids[THREAD_CNT - 1] + 1000) == -1, "join unknown tid");
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(thread-simple) begin
+(thread-simple) create thread 0
+(thread-simple) create thread 1
+(thread-simple) create thread 2
+(thread-simple) create thread 3
+(thread-simple) join thread 0
+(thread-simple) join thread 1
+(thread-simple) join thread 2
+(thread-simple) join thread 3
+(thread-simple) sums correct
+(thread-simple) join thread 0 again
+(thread-simple) join unknown tid
+(thread-simple) end
+thread-simple: exit(0)
+EOF
+pass;
@@ -0,0 +1,235 @@
+#include "threads/kmem.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x5ab1ca5e
+
+/* A slab: one page, with this header at its start and the
+   cache's objects after it.  A free object's link to the next
+   free object is kept just past the object's SIZE bytes, so that
+   a constructed object stays constructed while it is free. */
+struct slab
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct kmem_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in cache's partial list. */
+    void *free;                 /* First free object, or null. */
+    size_t free_cnt;            /* Number of free objects. */
+  };
+
+/* All caches that have been used, for kmem_print_stats().
+   Protected by caches_lock, with interrupts off. */
+static struct list caches = LIST_INITIALIZER (caches);
+static struct spinlock caches_lock;
+
+static void setup_cache (struct kmem_cache *);
+static struct slab *slab_create (struct kmem_cache *);
+static void **free_link (struct kmem_cache *, void *obj);
+
+/* Initializes cache C as a cache named NAME of SIZE-byte objects
+   aligned on ALIGN bytes, each constructed by CTOR, which may be
+   null. */
+void
+kmem_cache_init (struct kmem_cache *c, const char *name,
+                 size_t size, size_t align, kmem_ctor_func *ctor)
+{
+  struct kmem_cache init = KMEM_CACHE_INITIALIZER (name, size, align, ctor);
+  *c = init;
+}
+
+/* Allocates an object from cache C and returns it, or returns a
+   null pointer if memory is not available.  The object is in the
+   state its constructor left it, or the state it was freed in; it
+   is not zeroed. */
+void *
+kmem_cache_alloc (struct kmem_cache *c)
+{
+  enum intr_level old_level;
+  struct slab *s;
+  void *obj;
+
+  if (!c->ready)
+    setup_cache (c);
+
+  old_level = intr_disable ();
+  spinlock_acquire (&c->lock);
+  if (!list_empty (&c->partial))
+    s = list_entry (list_front (&c->partial), struct slab, elem);
+  else if (c->spare != NULL)
+    {
+      s = c->spare;
+      c->spare = NULL;
+      list_push_front (&c->partial, &s->elem);
+    }
+  else
+    {
+      /* Make a new slab without the lock, since constructing its
+         objects may take a while. */
+      spinlock_release (&c->lock);
+      intr_set_level (old_level);
+      s = slab_create (c);
+      if (s == NULL)
+        return NULL;
+      old_level = intr_disable ();
+      spinlock_acquire (&c->lock);
+      c->slab_cnt++;
+      list_push_front (&c->partial, &s->elem);
+    }
+
+  obj = s->free;
+  s->free = *free_link (c, obj);
+  if (--s->free_cnt == 0)
+    list_remove (&s->elem);
+
+  c->alloc_cnt++;
+  if (++c->in_use > c->peak_in_use)
+    c->peak_in_use = c->in_use;
+  spinlock_release (&c->lock);
+  intr_set_level (old_level);
+  return obj;
+}
+
+/* Returns OBJ, which must have been allocated from cache C, to
+   C.  Does nothing if OBJ is null.  May be called with interrupts
+   off. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj)
+{
+  enum intr_level old_level;
+  struct slab *s;
+  struct slab *release = NULL;
+
+  if (obj == NULL)
+    return;
+
+  s = pg_round_down (obj);
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (s->cache == c);
+  ASSERT ((pg_ofs (obj) - c->obj_ofs) % c->stride == 0);
+
+  old_level = intr_disable ();
+  spinlock_acquire (&c->lock);
+  *free_link (c, obj) = s->free;
+  s->free = obj;
+  c->in_use--;
+
+  /* A full slab goes back on the partial list.  An entirely free
+     slab becomes the spare, unless we already have one. */
+  if (++s->free_cnt == 1)
+    list_push_front (&c->partial, &s->elem);
+  if (s->free_cnt == c->objs_per_slab)
+    {
+      list_remove (&s->elem);
+      if (c->spare == NULL)
+        c->spare = s;
+      else
+        {
+          release = s;
+          c->slab_cnt--;
+        }
+    }
+  spinlock_release (&c->lock);
+  intr_set_level (old_level);
+
+  if (release != NULL)
+    {
+      release->magic = 0;
+      palloc_free_page (release);
+    }
+}
+
+/* Prints statistics for each cache that has been used. */
+void
+kmem_print_stats (void)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&caches); e != list_end (&caches); e = list_next (e))
+    {
+      struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+      printf ("Kmem: %s: %zu in use (peak %zu), %zu slabs, "
+              "%llu allocations\n",
+              c->name, c->in_use, c->peak_in_use, c->slab_cnt,
+              c->alloc_cnt);
+    }
+}
+
+/* Lays out cache C's slabs and adds C to the list of caches, if
+   that has not been done yet. */
+static void
+setup_cache (struct kmem_cache *c)
+{
+  enum intr_level old_level;
+  size_t link_ofs;
+
+  ASSERT (c->size > 0);
+  ASSERT (c->align > 0 && (c->align & (c->align - 1)) == 0);
+
+  old_level = intr_disable ();
+  spinlock_acquire (&caches_lock);
+  if (!c->ready)
+    {
+      size_t align = c->align > sizeof (void *) ? c->align : sizeof (void *);
+
+      link_ofs = ROUND_UP (c->size, sizeof (void *));
+      c->stride = ROUND_UP (link_ofs + sizeof (void *), align);
+      c->obj_ofs = ROUND_UP (sizeof (struct slab), align);
+      ASSERT (c->obj_ofs + c->stride <= PGSIZE);
+      c->objs_per_slab = (PGSIZE - c->obj_ofs) / c->stride;
+
+      spinlock_init_named (&c->lock, c->name);
+      list_init (&c->partial);
+      c->spare = NULL;
+      c->in_use = c->peak_in_use = c->slab_cnt = 0;
+      c->alloc_cnt = 0;
+      list_push_back (&caches, &c->elem);
+      c->ready = true;
+    }
+  spinlock_release (&caches_lock);
+  intr_set_level (old_level);
+}
+
+/* Allocates a slab for cache C, constructs its objects and links
+   them into its free list.  Returns the slab, or a null pointer
+   if memory is not available. */
+static struct slab *
+slab_create (struct kmem_cache *c)
+{
+  struct slab *s = palloc_get_page (0);
+  uint8_t *obj;
+  size_t i;
+
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = c;
+  s->free = NULL;
+  s->free_cnt = c->objs_per_slab;
+
+  /* Link the objects in address order. */
+  obj = (uint8_t *) s + c->obj_ofs + c->stride * c->objs_per_slab;
+  for (i = 0; i < c->objs_per_slab; i++)
+    {
+      obj -= c->stride;
+      if (c->ctor != NULL)
+        c->ctor (obj);
+      *free_link (c, obj) = s->free;
+      s->free = obj;
+    }
+  return s;
+}
+
+/* Returns the location of free object OBJ's link to the next free
+   object in its slab. */
+static void **
+free_link (struct kmem_cache *c, void *obj)
+{
+  return (void **) ((uint8_t *) obj + ROUND_UP (c->size, sizeof (void *)));
+}
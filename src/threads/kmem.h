@@ -0,0 +1,69 @@
+#ifndef THREADS_KMEM_H
+#define THREADS_KMEM_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "threads/spinlock.h"
+
+/* Object caches.
+
+   A cache hands out objects of one fixed size and alignment,
+   carved out of whole pages called "slabs", for a kernel
+   structure that is allocated and freed often.  Unlike malloc(),
+   which rounds a request up to the next of its size classes,
+   spaced about 1.25x apart, a cache packs objects as tightly as
+   their size allows.
+
+   If the cache has a constructor, it is run on each object once,
+   when the object's slab is created, not on every allocation.
+   An object must therefore be returned to the cache in its
+   constructed state.
+
+   A cache may be defined statically with KMEM_CACHE_INITIALIZER,
+   or initialized with kmem_cache_init().  Either way, it takes no
+   memory until its first allocation, so it may be set up before
+   the page allocator. */
+
+/* Object constructor. */
+typedef void kmem_ctor_func (void *obj);
+
+/* An object cache.  The members are private to kmem.c. */
+struct kmem_cache
+  {
+    const char *name;           /* Name, for statistics. */
+    size_t size;                /* Object size in bytes. */
+    size_t align;               /* Object alignment, a power of 2. */
+    kmem_ctor_func *ctor;       /* Constructor, or null. */
+
+    /* Set up on first use. */
+    bool ready;                 /* Members below initialized? */
+    size_t stride;              /* Bytes from one object to the next. */
+    size_t obj_ofs;             /* Offset of first object in a slab. */
+    size_t objs_per_slab;       /* Number of objects in a slab. */
+    struct list_elem elem;      /* Element in list of all caches. */
+
+    struct spinlock lock;       /* Protects the members below. */
+    struct list partial;        /* Slabs with some objects free. */
+    struct slab *spare;         /* Entirely free slab kept, or null. */
+
+    /* Statistics. */
+    size_t in_use;              /* Objects allocated now. */
+    size_t peak_in_use;         /* Most objects ever allocated at once. */
+    size_t slab_cnt;            /* Slabs now held. */
+    unsigned long long alloc_cnt; /* Total allocations. */
+  };
+
+/* Initializer for a cache named NAME of SIZE-byte objects aligned
+   on ALIGN bytes, each constructed by CTOR, which may be null. */
+#define KMEM_CACHE_INITIALIZER(NAME, SIZE, ALIGN, CTOR) \
+        { .name = (NAME), .size = (SIZE), .align = (ALIGN), .ctor = (CTOR) }
+
+void kmem_cache_init (struct kmem_cache *, const char *name,
+                      size_t size, size_t align, kmem_ctor_func *);
+void *kmem_cache_alloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+
+void kmem_print_stats (void);
+
+#endif /* threads/kmem.h */
@@ -5,41 +5,64 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
+#include "threads/loader.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
 
-   The size of each request, in bytes, is rounded up to a power
-   of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
+   The size of each request, in bytes, is rounded up to the
+   nearest size class and assigned to the "descriptor" that
+   manages blocks of that size.  Size classes are multiples of
+   16 bytes, each about 1.25 times the one before, from 16 bytes
+   up to MEDIUM_MAX.  The descriptor keeps a list of free blocks.  If
    the free list is nonempty, one of its blocks is used to
    satisfy the request.
 
-   Otherwise, a new page of memory, called an "arena", is
+   Otherwise, a new arena, one or more contiguous pages, is
    obtained from the page allocator (if none is available,
-   malloc() returns a null pointer).  The new arena is divided
-   into blocks, all of which are added to the descriptor's free
-   list.  Then we return one of the new blocks.
+   malloc() returns a null pointer).  The new arena is carved into
+   blocks lazily: the descriptor hands out its newest arena's
+   blocks in order, with a bump index, and only blocks that have
+   been freed ever go on the free list.
 
    When we free a block, we add it to its descriptor's free list.
    But if the arena that the block was in now has no in-use
    blocks, we remove all of the arena's blocks from the free list
    and give the arena back to the page allocator.
 
-   We can't handle blocks bigger than 2 kB using this scheme,
-   because they're too big to fit in a single page with a
-   descriptor.  We handle those by allocating contiguous pages
-   with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   The descriptor, with its lock, acts as a "depot" behind a
+   "magazine" for each size class: a small stack of free blocks
+   that is allocated from and freed to with only interrupts off.
+   An empty magazine is refilled, and a full one half emptied,
+   half a magazine's worth of blocks at a time under the
+   descriptor's lock, so most malloc() and free() calls never
+   touch the lock.  Blocks in magazines count as in use as far as
+   their arenas are concerned.
+
+   Small blocks share one-page arenas.  Medium blocks, too big
+   for a page to hold several of them, get arenas of up to
+   MAX_ARENA_PAGES pages, sized to hold at least MIN_ARENA_BLOCKS
+   blocks.  A block in such an arena may lie on any of its pages,
+   so page_arenas[] maps each of those pages back to the arena.
+
+   Blocks bigger than MEDIUM_MAX are handled by allocating
+   contiguous pages with the page allocator and sticking the
+   allocation size at the beginning of the allocated block's
+   arena header. */
 
 /* Descriptor. */
 struct desc
   {
     size_t block_size;          /* Size of each element in bytes. */
     size_t blocks_per_arena;    /* Number of blocks in an arena. */
+    size_t arena_pages;         /* Number of pages in an arena. */
+    size_t mag_rounds;          /* Capacity of a magazine. */
     struct list free_list;      /* List of free blocks. */
+    struct arena *bump_arena;   /* Arena with untouched blocks, or null. */
+    size_t bump_idx;            /* First untouched block in bump_arena. */
     struct lock lock;           /* Lock. */
   };
 
@@ -60,28 +83,101 @@ struct block
     struct list_elem free_elem; /* Free list element. */
   };
 
+/* Largest block size handled by a descriptor. */
+#define MEDIUM_MAX (16 * 1024)
+
+/* Arena size limits for medium blocks. */
+#define MIN_ARENA_BLOCKS 4      /* Blocks an arena should hold. */
+#define MAX_ARENA_PAGES 16      /* Upper bound on arena size. */
+
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+#define DESC_MAX 32
+static struct desc descs[DESC_MAX]; /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Descriptor index for each request size up to LOOKUP_MAX, in
+   units of 16 bytes, so that small requests find their
+   descriptor without a search. */
+#define LOOKUP_MAX 1024
+static uint8_t size_lookup[LOOKUP_MAX / 16 + 1];
+
+/* Arena of each page of RAM that belongs to a multi-page
+   arena, indexed by physical page number, or null. */
+static struct arena **page_arenas;
+
+/* Most blocks a magazine holds, and most bytes it should hold
+   for medium blocks. */
+#define MAG_ROUNDS 16
+#define MAG_BYTES (16 * 1024)
+
+/* Magazine: a cache of free blocks of one size class. */
+struct magazine
+  {
+    size_t cnt;                        /* Number of blocks held. */
+    struct block *rounds[MAG_ROUNDS];  /* Free blocks, newest last. */
+  };
+
+/* Magazines, by descriptor.  Only touched with interrupts off. */
+static struct magazine magazines[DESC_MAX];
+
+static struct desc *desc_for_size (size_t);
+static bool resize_in_place (void *block, size_t new_size);
+static void set_page_arenas (struct arena *, size_t page_cnt,
+                             struct arena *);
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static struct magazine *desc_magazine (struct desc *);
+static struct block *depot_get (struct desc *);
+static void depot_put (struct desc *, struct block *);
 
 /* Initializes the malloc() descriptors. */
 void
 malloc_init (void) 
 {
-  size_t block_size;
+  size_t block_size, next_size;
+  size_t map_pages, i;
 
-  for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2)
+  for (block_size = 16; block_size <= MEDIUM_MAX; block_size = next_size)
     {
       struct desc *d = &descs[desc_cnt++];
+      size_t arena_bytes;
+
       ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
       d->block_size = block_size;
-      d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
+      d->arena_pages = DIV_ROUND_UP (sizeof (struct arena)
+                                     + MIN_ARENA_BLOCKS * block_size,
+                                     PGSIZE);
+      if (d->arena_pages > MAX_ARENA_PAGES)
+        d->arena_pages = MAX_ARENA_PAGES;
+      arena_bytes = d->arena_pages * PGSIZE;
+      d->blocks_per_arena = (arena_bytes - sizeof (struct arena)) / block_size;
+      d->mag_rounds = MAG_BYTES / block_size;
+      if (d->mag_rounds > MAG_ROUNDS)
+        d->mag_rounds = MAG_ROUNDS;
+      if (d->mag_rounds < 2)
+        d->mag_rounds = 2;
       list_init (&d->free_list);
-      lock_init (&d->lock);
+      d->bump_arena = NULL;
+      d->bump_idx = 0;
+      lock_init_named (&d->lock, "malloc descriptor");
+
+      /* Next class: about 1.25 times as big, ending exactly at
+         MEDIUM_MAX. */
+      next_size = ROUND_UP (block_size + block_size / 4, 16);
+      if (next_size > MEDIUM_MAX && block_size < MEDIUM_MAX)
+        next_size = MEDIUM_MAX;
+    }
+
+  for (i = 0; i <= LOOKUP_MAX / 16; i++)
+    {
+      size_t d = 0;
+      while (descs[d].block_size < i * 16)
+        d++;
+      size_lookup[i] = d;
     }
+
+  map_pages = DIV_ROUND_UP (init_ram_pages * sizeof *page_arenas, PGSIZE);
+  page_arenas = palloc_get_multiple (PAL_ASSERT | PAL_ZERO, map_pages);
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -92,6 +188,10 @@ malloc (size_t size)
   struct desc *d;
   struct block *b;
   struct arena *a;
+  struct block *batch[MAG_ROUNDS / 2];
+  struct magazine *m;
+  enum intr_level old_level;
+  size_t n;
 
   /* A null pointer satisfies a request for 0 bytes. */
   if (size == 0)
@@ -99,10 +199,8 @@ malloc (size_t size)
 
   /* Find the smallest descriptor that satisfies a SIZE-byte
      request. */
-  for (d = descs; d < descs + desc_cnt; d++)
-    if (d->block_size >= size)
-      break;
-  if (d == descs + desc_cnt) 
+  d = desc_for_size (size);
+  if (d == NULL) 
     {
       /* SIZE is too big for any descriptor.
          Allocate enough pages to hold SIZE plus an arena. */
@@ -119,37 +217,46 @@ malloc (size_t size)
       return a + 1;
     }
 
-  lock_acquire (&d->lock);
-
-  /* If the free list is empty, create a new arena. */
-  if (list_empty (&d->free_list))
+  /* Take a block from the magazine if we can. */
+  old_level = intr_disable ();
+  m = desc_magazine (d);
+  if (m->cnt > 0) 
     {
-      size_t i;
-
-      /* Allocate a page. */
-      a = palloc_get_page (0);
-      if (a == NULL) 
-        {
-          lock_release (&d->lock);
-          return NULL; 
-        }
-
-      /* Initialize arena and add its blocks to the free list. */
-      a->magic = ARENA_MAGIC;
-      a->desc = d;
-      a->free_cnt = d->blocks_per_arena;
-      for (i = 0; i < d->blocks_per_arena; i++) 
-        {
-          struct block *b = arena_to_block (a, i);
-          list_push_back (&d->free_list, &b->free_elem);
-        }
+      b = m->rounds[--m->cnt];
+      intr_set_level (old_level);
+      return b;
     }
+  intr_set_level (old_level);
 
-  /* Get a block from free list and return it. */
-  b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-  a = block_to_arena (b);
-  a->free_cnt--;
+  /* Refill from the depot. */
+  lock_acquire (&d->lock);
+  for (n = 0; n < d->mag_rounds / 2; n++) 
+    {
+      batch[n] = depot_get (d);
+      if (batch[n] == NULL)
+        break;
+    }
   lock_release (&d->lock);
+  if (n == 0)
+    return NULL;
+
+  /* Keep the rest of the batch in the magazine.  We may have
+     been preempted by someone who filled the magazine in the
+     meantime. */
+  b = batch[--n];
+  old_level = intr_disable ();
+  m = desc_magazine (d);
+  while (n > 0 && m->cnt < d->mag_rounds)
+    m->rounds[m->cnt++] = batch[--n];
+  intr_set_level (old_level);
+
+  if (n > 0) 
+    {
+      lock_acquire (&d->lock);
+      while (n > 0)
+        depot_put (d, batch[--n]);
+      lock_release (&d->lock);
+    }
   return b;
 }
 
@@ -190,7 +297,9 @@ block_size (void *block)
    If successful, returns the new block; on failure, returns a
    null pointer.
    A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
-   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK). */
+   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK).
+   OLD_BLOCK is resized in place if NEW_SIZE maps to the same
+   size class, or, for a big block, to no more pages. */
 void *
 realloc (void *old_block, size_t new_size) 
 {
@@ -199,6 +308,8 @@ realloc (void *old_block, size_t new_size)
       free (old_block);
       return NULL;
     }
+  else if (old_block != NULL && resize_in_place (old_block, new_size))
+    return old_block;
   else 
     {
       void *new_block = malloc (new_size);
@@ -226,6 +337,11 @@ free (void *p)
       
       if (d != NULL) 
         {
+          struct block *batch[MAG_ROUNDS / 2];
+          struct magazine *m;
+          enum intr_level old_level;
+          size_t n;
+
           /* It's a normal block.  We handle it here. */
 
 #ifndef NDEBUG
@@ -233,25 +349,26 @@ free (void *p)
           memset (b, 0xcc, d->block_size);
 #endif
   
-          lock_acquire (&d->lock);
-
-          /* Add block to free list. */
-          list_push_front (&d->free_list, &b->free_elem);
-
-          /* If the arena is now entirely unused, free it. */
-          if (++a->free_cnt >= d->blocks_per_arena) 
+          /* Put the block in the magazine if there is room. */
+          old_level = intr_disable ();
+          m = desc_magazine (d);
+          if (m->cnt < d->mag_rounds) 
             {
-              size_t i;
-
-              ASSERT (a->free_cnt == d->blocks_per_arena);
-              for (i = 0; i < d->blocks_per_arena; i++) 
-                {
-                  struct block *b = arena_to_block (a, i);
-                  list_remove (&b->free_elem);
-                }
-              palloc_free_page (a);
+              m->rounds[m->cnt++] = b;
+              intr_set_level (old_level);
+              return;
             }
 
+          /* The magazine is full.  Return half of it, and the
+             block, to the depot. */
+          for (n = 0; n < d->mag_rounds / 2; n++)
+            batch[n] = m->rounds[--m->cnt];
+          intr_set_level (old_level);
+
+          lock_acquire (&d->lock);
+          depot_put (d, b);
+          while (n > 0)
+            depot_put (d, batch[--n]);
           lock_release (&d->lock);
         }
       else
@@ -267,7 +384,10 @@ free (void *p)
 static struct arena *
 block_to_arena (struct block *b)
 {
-  struct arena *a = pg_round_down (b);
+  struct arena *a = page_arenas[vtop (b) / PGSIZE];
+
+  if (a == NULL)
+    a = pg_round_down (b);
 
   /* Check that the arena is valid. */
   ASSERT (a != NULL);
@@ -275,7 +395,7 @@ block_to_arena (struct block *b)
 
   /* Check that the block is properly aligned for the arena. */
   ASSERT (a->desc == NULL
-          || (pg_ofs (b) - sizeof *a) % a->desc->block_size == 0);
+          || ((uint8_t *) b - (uint8_t *) (a + 1)) % a->desc->block_size == 0);
   ASSERT (a->desc != NULL || pg_ofs (b) == sizeof *a);
 
   return a;
@@ -292,3 +412,146 @@ arena_to_block (struct arena *a, size_t idx)
                            + sizeof *a
                            + idx * a->desc->block_size);
 }
+
+/* Returns the magazine for descriptor D.  Interrupts must be
+   off. */
+static struct magazine *
+desc_magazine (struct desc *d) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  return &magazines[d - descs];
+}
+
+/* Takes a free block from descriptor D's depot and returns it,
+   first from the free list, then from the untouched part of the
+   bump arena, and last from a new arena.  Returns a null pointer
+   if memory is not available.  D's lock must be held. */
+static struct block *
+depot_get (struct desc *d) 
+{
+  struct block *b;
+  struct arena *a;
+
+  ASSERT (lock_held_by_current_thread (&d->lock));
+
+  if (!list_empty (&d->free_list)) 
+    {
+      b = list_entry (list_pop_front (&d->free_list),
+                      struct block, free_elem);
+      a = block_to_arena (b);
+    }
+  else 
+    {
+      if (d->bump_arena == NULL || d->bump_idx >= d->blocks_per_arena) 
+        {
+          /* Start a new arena. */
+          a = palloc_get_multiple (0, d->arena_pages);
+          if (a == NULL)
+            return NULL;
+          if (d->arena_pages > 1)
+            set_page_arenas (a, d->arena_pages, a);
+          a->magic = ARENA_MAGIC;
+          a->desc = d;
+          a->free_cnt = d->blocks_per_arena;
+          d->bump_arena = a;
+          d->bump_idx = 0;
+        }
+      a = d->bump_arena;
+      b = arena_to_block (a, d->bump_idx++);
+    }
+  a->free_cnt--;
+  return b;
+}
+
+/* Returns block B to descriptor D's depot.  If B's arena is then
+   entirely unused, gives the arena back to the page allocator.
+   D's lock must be held. */
+static void
+depot_put (struct desc *d, struct block *b) 
+{
+  struct arena *a = block_to_arena (b);
+
+  ASSERT (lock_held_by_current_thread (&d->lock));
+
+  /* Add block to free list. */
+  list_push_front (&d->free_list, &b->free_elem);
+
+  /* If the arena is now entirely unused, free it.  Only the
+     blocks it has handed out are on the free list. */
+  if (++a->free_cnt >= d->blocks_per_arena) 
+    {
+      size_t used_cnt = d->blocks_per_arena;
+      size_t i;
+
+      ASSERT (a->free_cnt == d->blocks_per_arena);
+      if (a == d->bump_arena) 
+        {
+          used_cnt = d->bump_idx;
+          d->bump_arena = NULL;
+        }
+      for (i = 0; i < used_cnt; i++) 
+        {
+          struct block *b = arena_to_block (a, i);
+          list_remove (&b->free_elem);
+        }
+      if (d->arena_pages > 1)
+        set_page_arenas (a, d->arena_pages, NULL);
+      palloc_free_multiple (a, d->arena_pages);
+    }
+}
+
+/* Returns the smallest descriptor for blocks of at least SIZE
+   bytes, or a null pointer if SIZE is too big for any. */
+static struct desc *
+desc_for_size (size_t size) 
+{
+  struct desc *d;
+
+  ASSERT (size > 0);
+  if (size <= LOOKUP_MAX)
+    return &descs[size_lookup[DIV_ROUND_UP (size, 16)]];
+
+  for (d = &descs[size_lookup[LOOKUP_MAX / 16]]; d < descs + desc_cnt; d++)
+    if (d->block_size >= size)
+      return d;
+  return NULL;
+}
+
+/* Tries to resize BLOCK to NEW_SIZE bytes without moving it.
+   A block in a descriptor stays put if NEW_SIZE maps to the same
+   descriptor.  A big block stays put if NEW_SIZE is still too
+   big for a descriptor and needs no more pages; pages it no
+   longer needs are freed.  Returns true if successful. */
+static bool
+resize_in_place (void *block, size_t new_size) 
+{
+  struct arena *a = block_to_arena (block);
+  struct desc *d = desc_for_size (new_size);
+  size_t page_cnt;
+
+  if (a->desc != NULL || d != NULL)
+    return a->desc == d;
+
+  page_cnt = DIV_ROUND_UP (new_size + sizeof *a, PGSIZE);
+  if (page_cnt > a->free_cnt)
+    return false;
+  if (page_cnt < a->free_cnt) 
+    {
+      palloc_free_multiple ((uint8_t *) a + page_cnt * PGSIZE,
+                            a->free_cnt - page_cnt);
+      a->free_cnt = page_cnt;
+    }
+  return true;
+}
+
+/* Sets the page_arenas[] entries for the PAGE_CNT pages starting
+   at arena A to ARENA. */
+static void
+set_page_arenas (struct arena *a, size_t page_cnt, struct arena *arena) 
+{
+  size_t first = vtop (a) / PGSIZE;
+  size_t i;
+
+  for (i = 0; i < page_cnt; i++)
+    page_arenas[first + i] = arena;
+}
@@ -1,14 +1,17 @@
 #include "threads/palloc.h"
-#include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
+#include "threads/spinlock.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -23,22 +26,80 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
 
-/* A memory pool. */
+   Each pool is managed as a buddy system.  Free memory is kept
+   in blocks of 2**ORDER pages, aligned to their size relative to
+   the pool's base, on one free list per order.  An allocation
+   takes a block of the smallest order that fits, splitting
+   larger blocks as needed, and gives back the pages it does not
+   need.  Freeing a block merges it with its buddy, the other
+   half of the block of the next order up, for as long as the
+   buddy is free too.  Both take O(log n) time.
+
+   Each pool also keeps a short list of free pages that are
+   already filled with zeros, so that a single-page PAL_ZERO
+   request does not have to zero its page itself.  A kernel
+   thread at the lowest priority, the zeroer, takes free pages
+   out of the buddy system, zeros them, and keeps the list topped
+   up to ZEROED_MAX pages.  An allocation that finds the buddy
+   system exhausted puts them back before giving up. */
+
+/* Largest block order.  A pool larger than 2**MAX_ORDER pages is
+   simply kept as several top-order blocks. */
+#define MAX_ORDER 16
+
+/* Entry in a pool's orders[] array for a page that does not begin
+   a free block. */
+#define NOT_FREE 0xff
+
+/* Most pre-zeroed pages kept per pool. */
+#define ZEROED_MAX 32
+
+/* A memory pool.
+
+   Every operation is short, so a pool is protected by a spinlock
+   with interrupts off rather than a sleeping lock.  That also
+   lets the scheduler free a dead thread's page. */
 struct pool
   {
-    struct lock lock;                   /* Mutual exclusion. */
-    struct bitmap *used_map;            /* Bitmap of free pages. */
+    struct spinlock lock;               /* Mutual exclusion. */
     uint8_t *base;                      /* Base of pool. */
+    size_t page_cnt;                    /* Number of pages. */
+
+    /* Buddy system.  A free block's first page holds its element
+       in free[], and orders[] gives the order of the free block
+       beginning at each page, or NOT_FREE. */
+    struct list free[MAX_ORDER + 1];    /* Free blocks, by order. */
+    uint8_t *orders;                    /* One entry per page. */
+
+    /* Pre-zeroed pages, allocated from the buddy system. */
+    struct list zeroed;                 /* Zeroed pages. */
+    size_t zeroed_cnt;                  /* Number of pages on list. */
+    bool refill_pending;                /* Zeroer has been woken. */
   };
 
+/* Returned by buddy_get() on failure. */
+#define BUDDY_ERROR SIZE_MAX
+
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
+/* Upped to wake the zeroer when a list runs low. */
+static struct semaphore zeroer_wake;
+
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
 static bool page_from_pool (const struct pool *, void *page);
+static size_t buddy_get (struct pool *, size_t page_cnt);
+static size_t buddy_get_run (struct pool *, size_t page_cnt);
+static void buddy_put (struct pool *, size_t page_idx, size_t page_cnt);
+static void buddy_put_block (struct pool *, size_t page_idx,
+                             unsigned order);
+static void *zeroed_pop (struct pool *);
+static size_t zeroed_reclaim (struct pool *);
+static bool zeroed_refill (struct pool *);
+static thread_func zeroer;
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -59,6 +120,19 @@ palloc_init (size_t user_page_limit)
   init_pool (&kernel_pool, free_start, kernel_pages, "kernel pool");
   init_pool (&user_pool, free_start + kernel_pages * PGSIZE,
              user_pages, "user pool");
+  sema_init (&zeroer_wake, 0);
+}
+
+/* Starts the thread that zeros free pages in the background.
+   Must be called after thread_start(). */
+void
+palloc_start_zeroer (void) 
+{
+  struct semaphore started;
+
+  sema_init (&started, 0);
+  thread_create ("zeroer", PRI_MIN, zeroer, &started, NULL);
+  sema_down (&started);
 }
 
 /* Obtains and returns a group of PAGE_CNT contiguous free pages.
@@ -66,22 +140,42 @@ palloc_init (size_t user_page_limit)
    otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
    then the pages are filled with zeros.  If too few pages are
    available, returns a null pointer, unless PAL_ASSERT is set in
-   FLAGS, in which case the kernel panics. */
+   FLAGS, in which case the kernel panics.
+
+   The pages are normally carved from a free block of the
+   smallest power of 2 pages that holds PAGE_CNT of them, which
+   is aligned to its size relative to the pool's base, and the
+   pages beyond PAGE_CNT go straight back to the free lists.  If
+   no such aligned block is free, the pages are taken from any
+   run of adjacent free blocks long enough to hold them, which
+   takes time linear in the number of free blocks. */
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 {
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+  enum intr_level old_level;
   void *pages;
   size_t page_idx;
 
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
+  if ((flags & PAL_ZERO) && page_cnt == 1)
+    {
+      pages = zeroed_pop (pool);
+      if (pages != NULL)
+        return pages;
+    }
+
+  old_level = intr_disable ();
+  spinlock_acquire (&pool->lock);
+  page_idx = buddy_get (pool, page_cnt);
+  if (page_idx == BUDDY_ERROR && zeroed_reclaim (pool) > 0)
+    page_idx = buddy_get (pool, page_cnt);
+  spinlock_release (&pool->lock);
+  intr_set_level (old_level);
 
-  if (page_idx != BITMAP_ERROR)
+  if (page_idx != BUDDY_ERROR)
     pages = pool->base + PGSIZE * page_idx;
   else
     pages = NULL;
@@ -113,11 +207,13 @@ palloc_get_page (enum palloc_flags flags)
   return palloc_get_multiple (flags, 1);
 }
 
-/* Frees the PAGE_CNT pages starting at PAGES. */
+/* Frees the PAGE_CNT pages starting at PAGES.  May be called with
+   interrupts off. */
 void
 palloc_free_multiple (void *pages, size_t page_cnt) 
 {
   struct pool *pool;
+  enum intr_level old_level;
   size_t page_idx;
 
   ASSERT (pg_ofs (pages) == 0);
@@ -132,13 +228,17 @@ palloc_free_multiple (void *pages, size_t page_cnt)
     NOT_REACHED ();
 
   page_idx = pg_no (pages) - pg_no (pool->base);
+  ASSERT (page_idx + page_cnt <= pool->page_cnt);
 
 #ifndef NDEBUG
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
-  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  old_level = intr_disable ();
+  spinlock_acquire (&pool->lock);
+  buddy_put (pool, page_idx, page_cnt);
+  spinlock_release (&pool->lock);
+  intr_set_level (old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -153,20 +253,31 @@ palloc_free_page (void *page)
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
+  /* We'll put the pool's orders[] array at its base.
+     Calculate the space needed for the array
      and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
-  if (bm_pages > page_cnt)
-    PANIC ("Not enough memory in %s for bitmap.", name);
-  page_cnt -= bm_pages;
+  size_t meta_pages = DIV_ROUND_UP (page_cnt, PGSIZE);
+  unsigned order;
+  if (meta_pages > page_cnt)
+    PANIC ("Not enough memory in %s for buddy map.", name);
+  page_cnt -= meta_pages;
 
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
   /* Initialize the pool. */
-  lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
-  p->base = base + bm_pages * PGSIZE;
+  spinlock_init_named (&p->lock, name);
+  p->base = (uint8_t *) base + meta_pages * PGSIZE;
+  p->page_cnt = page_cnt;
+  for (order = 0; order <= MAX_ORDER; order++)
+    list_init (&p->free[order]);
+  p->orders = base;
+  memset (p->orders, NOT_FREE, page_cnt);
+  list_init (&p->zeroed);
+  p->zeroed_cnt = 0;
+  p->refill_pending = false;
+
+  /* Everything starts out free. */
+  buddy_put (p, 0, page_cnt);
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -176,7 +287,266 @@ page_from_pool (const struct pool *pool, void *page)
 {
   size_t page_no = pg_no (page);
   size_t start_page = pg_no (pool->base);
-  size_t end_page = start_page + bitmap_size (pool->used_map);
+  size_t end_page = start_page + pool->page_cnt;
 
   return page_no >= start_page && page_no < end_page;
 }
+
+/* Returns the free block that begins at page PAGE_IDX of POOL. */
+static struct list_elem *
+block_elem (struct pool *pool, size_t page_idx) 
+{
+  return (struct list_elem *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL's buddy system
+   and returns the index of the first, or BUDDY_ERROR if there
+   are not that many contiguous free pages.  POOL's lock must be
+   held. */
+static size_t
+buddy_get (struct pool *pool, size_t page_cnt) 
+{
+  unsigned want, order;
+  size_t page_idx;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (want = 0; ((size_t) 1 << want) < page_cnt; want++)
+    if (want == MAX_ORDER)
+      return buddy_get_run (pool, page_cnt);
+
+  for (order = want; list_empty (&pool->free[order]); order++)
+    if (order == MAX_ORDER)
+      return buddy_get_run (pool, page_cnt);
+
+  page_idx = (pg_no (list_pop_front (&pool->free[order]))
+              - pg_no (pool->base));
+  pool->orders[page_idx] = NOT_FREE;
+
+  /* Split off the upper halves until the block is small
+     enough. */
+  while (order > want)
+    {
+      order--;
+      buddy_put_block (pool, page_idx + ((size_t) 1 << order), order);
+    }
+
+  /* Give back the pages beyond PAGE_CNT, so that a request that
+     is not a power of 2 only ties up the pages it asked for. */
+  buddy_put (pool, page_idx + page_cnt,
+             ((size_t) 1 << want) - page_cnt);
+  return page_idx;
+}
+
+/* Allocates PAGE_CNT contiguous pages from a run of adjacent
+   free blocks in POOL, for when no single aligned block can
+   supply them, and returns the index of the first, or
+   BUDDY_ERROR if no run is long enough.  POOL's lock must be
+   held. */
+static size_t
+buddy_get_run (struct pool *pool, size_t page_cnt) 
+{
+  unsigned order;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (order = 0; order <= MAX_ORDER; order++) 
+    {
+      struct list_elem *e;
+
+      for (e = list_begin (&pool->free[order]);
+           e != list_end (&pool->free[order]); e = list_next (e)) 
+        {
+          size_t start = pg_no (e) - pg_no (pool->base);
+          size_t end = start;
+          size_t idx;
+
+          while (end - start < page_cnt && end < pool->page_cnt
+                 && pool->orders[end] != NOT_FREE)
+            end += (size_t) 1 << pool->orders[end];
+          if (end - start < page_cnt)
+            continue;
+
+          for (idx = start; idx < end; ) 
+            {
+              unsigned block_order = pool->orders[idx];
+
+              list_remove (block_elem (pool, idx));
+              pool->orders[idx] = NOT_FREE;
+              idx += (size_t) 1 << block_order;
+            }
+          buddy_put (pool, start + page_cnt, end - start - page_cnt);
+          return start;
+        }
+    }
+  return BUDDY_ERROR;
+}
+
+/* Returns the PAGE_CNT pages starting at PAGE_IDX to POOL's buddy
+   system, as the largest aligned blocks that cover them.  POOL's
+   lock must be held. */
+static void
+buddy_put (struct pool *pool, size_t page_idx, size_t page_cnt) 
+{
+  while (page_cnt > 0)
+    {
+      unsigned order = 0;
+
+      while (order < MAX_ORDER
+             && page_idx % ((size_t) 2 << order) == 0
+             && ((size_t) 2 << order) <= page_cnt)
+        order++;
+
+      buddy_put_block (pool, page_idx, order);
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* Frees the block of 2**ORDER pages that begins at PAGE_IDX in
+   POOL, merging it with its buddy for as long as the buddy is
+   free.  POOL's lock must be held. */
+static void
+buddy_put_block (struct pool *pool, size_t page_idx, unsigned order) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (page_idx % ((size_t) 1 << order) == 0);
+  ASSERT (pool->orders[page_idx] == NOT_FREE);
+
+  while (order < MAX_ORDER)
+    {
+      size_t buddy_idx = page_idx ^ ((size_t) 1 << order);
+
+      if (buddy_idx >= pool->page_cnt || pool->orders[buddy_idx] != order)
+        break;
+      list_remove (block_elem (pool, buddy_idx));
+      pool->orders[buddy_idx] = NOT_FREE;
+      page_idx &= ~((size_t) 1 << order);
+      order++;
+    }
+
+  pool->orders[page_idx] = order;
+  list_push_front (&pool->free[order], block_elem (pool, page_idx));
+}
+
+/* Takes a page off POOL's pre-zeroed list and returns it, or
+   returns a null pointer if the list is empty.  Wakes the zeroer
+   if the list has run low. */
+static void *
+zeroed_pop (struct pool *pool) 
+{
+  enum intr_level old_level;
+  struct list_elem *e = NULL;
+  bool wake = false;
+
+  old_level = intr_disable ();
+  spinlock_acquire (&pool->lock);
+  if (!list_empty (&pool->zeroed))
+    {
+      e = list_pop_front (&pool->zeroed);
+      pool->zeroed_cnt--;
+    }
+  if (pool->zeroed_cnt < ZEROED_MAX / 2 && !pool->refill_pending)
+    wake = pool->refill_pending = true;
+  spinlock_release (&pool->lock);
+  intr_set_level (old_level);
+
+  if (wake)
+    sema_up (&zeroer_wake);
+  if (e == NULL)
+    return NULL;
+
+  /* The list element lived in the page itself. */
+  memset (e, 0, sizeof *e);
+  return e;
+}
+
+/* Returns all of POOL's pre-zeroed pages to its buddy system,
+   and returns the number of pages returned.  POOL's lock must be
+   held. */
+static size_t
+zeroed_reclaim (struct pool *pool) 
+{
+  size_t cnt = pool->zeroed_cnt;
+
+  while (!list_empty (&pool->zeroed))
+    {
+      void *page = list_pop_front (&pool->zeroed);
+      buddy_put_block (pool, pg_no (page) - pg_no (pool->base), 0);
+    }
+  pool->zeroed_cnt = 0;
+  return cnt;
+}
+
+/* Zeros one free page of POOL and adds it to POOL's pre-zeroed
+   list.  Returns false if the list is full or POOL has no free
+   pages. */
+static bool
+zeroed_refill (struct pool *pool) 
+{
+  enum intr_level old_level;
+  size_t page_idx = BUDDY_ERROR;
+  uint8_t *page;
+
+  old_level = intr_disable ();
+  spinlock_acquire (&pool->lock);
+  if (pool->zeroed_cnt < ZEROED_MAX)
+    page_idx = buddy_get (pool, 1);
+  spinlock_release (&pool->lock);
+  intr_set_level (old_level);
+  if (page_idx == BUDDY_ERROR)
+    return false;
+
+  /* Zero with the lock released, so allocations are not held
+     up behind us. */
+  page = pool->base + PGSIZE * page_idx;
+  memset (page, 0, PGSIZE);
+
+  old_level = intr_disable ();
+  spinlock_acquire (&pool->lock);
+  list_push_back (&pool->zeroed, (struct list_elem *) page);
+  pool->zeroed_cnt++;
+  spinlock_release (&pool->lock);
+  intr_set_level (old_level);
+  return true;
+}
+
+/* The zeroer thread.  Tops up both pools' pre-zeroed lists, a
+   page at a time, then sleeps until one of them runs low. */
+static void
+zeroer (void *started_) 
+{
+  struct semaphore *started = started_;
+
+  /* The advanced schedulers ignore the priority we were created
+     with, so ask for the smallest share they give out instead.
+     Zeroing ahead of demand is not load, so keep it out of
+     load_avg too. */
+  if (thread_mlfqs || thread_cfs)
+    thread_set_nice (20);
+  thread_exclude_from_load ();
+  sema_up (started);
+
+  for (;;) 
+    {
+      struct pool *pools[] = {&kernel_pool, &user_pool};
+      bool more[] = {true, true};
+      size_t i;
+
+      for (i = 0; i < 2; i++)
+        {
+          enum intr_level old_level = intr_disable ();
+          spinlock_acquire (&pools[i]->lock);
+          pools[i]->refill_pending = false;
+          spinlock_release (&pools[i]->lock);
+          intr_set_level (old_level);
+        }
+
+      while (more[0] || more[1])
+        for (i = 0; i < 2; i++)
+          if (more[i])
+            more[i] = zeroed_refill (pools[i]);
+
+      sema_down (&zeroer_wake);
+    }
+}
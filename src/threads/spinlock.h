@@ -0,0 +1,118 @@
+#ifndef THREADS_SPINLOCK_H
+#define THREADS_SPINLOCK_H
+
+#include <debug.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
+#ifdef LOCK_PROFILE
+#include "devices/timer.h"
+#endif
+
+/* Spinlock.
+
+   A spinlock protects data that is touched with interrupts off,
+   such as the page allocator's pools.  Disabling interrupts keeps
+   other threads and interrupt handlers away from the data; the
+   spinlock would keep other CPUs away, if the kernel ran threads
+   on more than one.  It must therefore only be acquired with
+   interrupts off, and held only for a short, non-blocking
+   section.  Use a struct lock (synch.h) for anything else. */
+struct spinlock
+  {
+    volatile uint32_t locked;   /* Nonzero while held. */
+#ifdef LOCK_PROFILE
+    struct lock_class *class;   /* Statistics, or null if untracked. */
+    int64_t acquired_at;        /* Tick at which holder acquired us. */
+#endif
+  };
+
+#ifdef LOCK_PROFILE
+/* Contention accounting, shared with struct lock; see synch.c. */
+struct lock_class *lock_class_lookup (const char *name);
+void spinlock_profile_acquired (struct spinlock *, bool contended,
+                                int64_t wait_start);
+void spinlock_profile_released (struct spinlock *);
+#endif
+
+/* Atomically stores NEW into *P and returns the old value. */
+static inline uint32_t
+spinlock_xchg (volatile uint32_t *p, uint32_t new)
+{
+  /* `xchg' with a memory operand is implicitly locked, and acts
+     as a full memory barrier.  See [IA32-v2b] "XCHG". */
+  asm volatile ("xchgl %0, %1" : "+r" (new), "+m" (*p) : : "memory");
+  return new;
+}
+
+/* Initializes an unheld spinlock named after the expression that
+   names it, e.g. "&queue_lock".  Use spinlock_init_named() to
+   pick a better name; locks with the same name share their
+   statistics. */
+#define spinlock_init(L) spinlock_init_named (L, #L)
+
+/* Initializes L as an unheld spinlock named NAME. */
+static inline void
+spinlock_init_named (struct spinlock *l, const char *name UNUSED)
+{
+  l->locked = 0;
+#ifdef LOCK_PROFILE
+  l->class = lock_class_lookup (name);
+  l->acquired_at = 0;
+#endif
+}
+
+/* Tries to acquire L without spinning.  Returns true if
+   successful, false if L was already held.  Interrupts must be
+   off. */
+static inline bool
+spinlock_try_acquire (struct spinlock *l)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  if (spinlock_xchg (&l->locked, 1) != 0)
+    return false;
+#ifdef LOCK_PROFILE
+  spinlock_profile_acquired (l, false, 0);
+#endif
+  return true;
+}
+
+/* Acquires L, spinning until it is available.  Interrupts must be
+   off.  L is not recursive. */
+static inline void
+spinlock_acquire (struct spinlock *l)
+{
+#ifdef LOCK_PROFILE
+  int64_t wait_start = timer_ticks ();
+  bool contended = false;
+#endif
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  while (spinlock_xchg (&l->locked, 1) != 0)
+    {
+#ifdef LOCK_PROFILE
+      contended = true;
+#endif
+      while (l->locked)
+        asm volatile ("pause");
+    }
+#ifdef LOCK_PROFILE
+  spinlock_profile_acquired (l, contended, wait_start);
+#endif
+}
+
+/* Releases L.  Stores are not reordered with older stores on x86,
+   so a compiler barrier is enough to publish the critical
+   section before L is seen as free. */
+static inline void
+spinlock_release (struct spinlock *l)
+{
+  ASSERT (l->locked);
+#ifdef LOCK_PROFILE
+  spinlock_profile_released (l);
+#endif
+  asm volatile ("" : : : "memory");
+  l->locked = 0;
+}
+
+#endif /* threads/spinlock.h */
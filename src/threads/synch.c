@@ -29,8 +29,63 @@
 #include "threads/synch.h"
 #include <stdio.h>
 #include <string.h>
+#include "devices/timer.h"
 #include "threads/interrupt.h"
+#include "threads/spinlock.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+
+/* Longest chain of nested donations that donate_priority()
+   follows. */
+#define DONATION_DEPTH_MAX 8
+
+static void held_locks_insert (struct thread *, struct lock *);
+static void held_locks_remove (struct thread *, struct lock *);
+static void held_locks_sift_up (struct thread *, int index);
+static int sema_max_waiter_priority (struct semaphore *);
+static int lock_raised_priority (struct lock *);
+static int waiters_max_priority (struct heap *);
+static void donate_to_lock (struct lock *, int priority, int depth);
+static void donate_to_rwlock (struct rwlock *, int priority, int depth);
+static void donate_to_holder (struct thread *, int priority, int depth);
+static void rwlock_wait (struct rwlock *, struct heap *waiters);
+static void rwlock_grant (struct rwlock *);
+static void held_rwlocks_insert (struct thread *, struct rwlock *);
+static void held_rwlocks_remove (struct thread *, struct rwlock *);
+
+#ifdef LOCK_PROFILE
+/* Contention statistics, kept per lock name.  Locks are often
+   short-lived objects on some thread's stack, so statistics live
+   in a fixed table of lock classes, one per distinct name, that
+   outlives them.  Locks, reader-writer locks and spinlocks all
+   keep their statistics here. */
+struct lock_class
+  {
+    const char *name;           /* Name given at initialization. */
+    unsigned acquisitions;      /* # of times acquired. */
+    unsigned contended;         /* # of acquisitions that had to wait. */
+    int64_t wait_ticks;         /* Total ticks spent waiting. */
+    int64_t max_wait_ticks;     /* Longest wait. */
+    int64_t max_hold_ticks;     /* Longest time held. */
+  };
+
+#define LOCK_CLASS_MAX 64       /* Distinct lock names tracked. */
+#define LOCK_PRINT_MAX 10       /* Classes printed at shutdown. */
+static struct lock_class lock_classes[LOCK_CLASS_MAX];
+static int lock_class_cnt;
+
+static int64_t lock_class_acquired (struct lock_class *, bool contended,
+                                     int64_t wait_start);
+static void lock_class_released (struct lock_class *, int64_t acquired_at);
+static void lock_profile_acquired (struct lock *, bool contended,
+                                   int64_t wait_start);
+static void lock_profile_released (struct lock *);
+static void rwlock_profile_acquired (struct rwlock *, bool contended,
+                                     int64_t wait_start);
+static void rwlock_profile_held (struct rwlock *);
+#endif
+static heap_less_func sema_waiter_less;
+static heap_less_func cond_waiter_less;
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -46,7 +101,16 @@ void sema_init(struct semaphore *sema, unsigned value)
   ASSERT(sema != NULL);
 
   sema->value = value;
-  list_init(&sema->waiters);
+  heap_init(&sema->waiters, sema_waiter_less, NULL);
+}
+
+/* Orders threads in a semaphore's waiter heap by priority. */
+static bool
+sema_waiter_less(const struct heap_elem *a, const struct heap_elem *b,
+                 void *aux UNUSED)
+{
+  return heap_entry(a, struct thread, wait_elem)->priority
+         < heap_entry(b, struct thread, wait_elem)->priority;
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -58,13 +122,21 @@ void sema_init(struct semaphore *sema, unsigned value)
    thread will probably turn interrupts back on. */
 void sema_down(struct semaphore *sema)
 {
+  struct thread *cur = thread_current ();
   enum intr_level old_level;
+
   ASSERT (sema != NULL);
   ASSERT (!intr_context ());
+
   old_level = intr_disable ();
   while (sema->value == 0) 
     {
-      list_insert_ordered(&sema->waiters, &thread_current ()->elem, priority_less, NULL);
+      heap_insert (&sema->waiters, &cur->wait_elem);
+      if (cur->wait_heap == NULL)
+        {
+          cur->wait_heap = &sema->waiters;
+          cur->wait_heap_elem = &cur->wait_elem;
+        }
       thread_block ();
     }
   sema->value--;
@@ -109,17 +181,16 @@ void sema_up(struct semaphore *sema) {
 
   old_level = intr_disable(); 
   sema->value++;
-  if (!list_empty (&sema->waiters)) {
-    // Sort the waiters list by priority before popping
-    list_sort(&sema->waiters, priority_less, NULL);
-    
+  if (!heap_empty (&sema->waiters)) {
     // Unblock the highest priority waiter
-    unblocked_thread = list_entry(list_pop_front(&sema->waiters),
-                                  struct thread, elem);
+    unblocked_thread = heap_entry(heap_pop(&sema->waiters),
+                                  struct thread, wait_elem);
+    if (unblocked_thread->wait_heap == &sema->waiters)
+      unblocked_thread->wait_heap = NULL;
     thread_unblock(unblocked_thread);
     
-    // Yield if the unblocked thread has higher priority
-    if (!intr_context() && unblocked_thread->priority > thread_current()->priority)
+    // Yield if the unblocked thread should run first
+    if (!intr_context() && thread_preempts(unblocked_thread, thread_current()))
       thread_yield();
   }
   intr_set_level(old_level);
@@ -176,13 +247,43 @@ sema_test_helper(void *sema_)
    another one "up" it, but with a lock the same thread must both
    acquire and release it.  When these restrictions prove
    onerous, it's a good sign that a semaphore should be used,
-   instead of a lock. */
-void lock_init(struct lock *lock)
+   instead of a lock.
+
+   A thread that waits for a lock donates its priority to the
+   holder.  See lock_init_ceiling_named() for the alternative. */
+void lock_init_named(struct lock *lock, const char *name UNUSED)
 {
   ASSERT(lock != NULL);
 
   lock->holder = NULL;
+  lock->max_waiter_priority = -1;
+  lock->heap_index = -1;
+  lock->ceiling = -1;
   sema_init(&lock->semaphore, 1);
+#ifdef LOCK_PROFILE
+  lock->class = lock_class_lookup(name);
+  lock->acquired_at = 0;
+#endif
+}
+
+/* Initializes LOCK as a lock that follows the immediate priority
+   ceiling protocol instead of priority donation.  Its holder runs
+   at CEILING, or at its own priority if that is higher, from the
+   moment it acquires LOCK until it releases it.  CEILING should
+   be at least the priority of any thread that ever acquires LOCK:
+   then no such thread can preempt the holder, so the holder is
+   never delayed by a thread of middling priority, acquiring LOCK
+   never walks a chain of holders, and waiters, which can then only
+   queue up behind a holder that blocked, never donate.
+
+   The ceiling has no effect under the advanced schedulers, where
+   LOCK behaves as a plain lock. */
+void lock_init_ceiling_named(struct lock *lock, const char *name, int ceiling)
+{
+  ASSERT(PRI_MIN <= ceiling && ceiling <= PRI_MAX);
+
+  lock_init_named(lock, name);
+  lock->ceiling = ceiling;
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -195,20 +296,37 @@ void lock_init(struct lock *lock)
    we need to sleep. */
 void lock_acquire(struct lock *lock)
 {
+  struct thread *current = thread_current();
+  enum intr_level old_level;
+  bool contended;
+#ifdef LOCK_PROFILE
+  int64_t wait_start = timer_ticks();
+#endif
+
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (!lock_held_by_current_thread (lock));
-  
-  struct thread *holder = lock->holder;
-  struct thread *current = thread_current();
-  if (holder != NULL)
+
+  old_level = intr_disable ();
+  contended = lock->holder != NULL;
+  if (contended && lock->ceiling < 0)
   {
-      current->waiting_on_lock = lock;
-      donate_priority(lock);
+    current->waiting_on_lock = lock;
+    donate_priority(lock);
   }
   sema_down(&lock->semaphore);
+  current->waiting_on_lock = NULL;
+#ifdef LOCK_PROFILE
+  lock_profile_acquired(lock, contended, wait_start);
+#endif
+
+  /* Threads still waiting now donate to us, or we rise to the
+     ceiling. */
   lock->holder = current;
-  // current->waiting_on_lock = NULL;
+  lock->max_waiter_priority = lock_raised_priority(lock);
+  held_locks_insert(current, lock);
+  refresh_priority();
+  intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -219,14 +337,25 @@ void lock_acquire(struct lock *lock)
    interrupt handler. */
 bool lock_try_acquire(struct lock *lock)
 {
+  enum intr_level old_level;
   bool success;
 
   ASSERT(lock != NULL);
   ASSERT(!lock_held_by_current_thread(lock));
 
+  old_level = intr_disable();
   success = sema_try_down(&lock->semaphore);
   if (success)
+  {
+#ifdef LOCK_PROFILE
+    lock_profile_acquired(lock, false, timer_ticks());
+#endif
     lock->holder = thread_current();
+    lock->max_waiter_priority = lock_raised_priority(lock);
+    held_locks_insert(lock->holder, lock);
+    refresh_priority();
+  }
+  intr_set_level(old_level);
   return success;
 }
 
@@ -237,18 +366,29 @@ bool lock_try_acquire(struct lock *lock)
    handler. */
 void lock_release(struct lock *lock)
 {
+  enum intr_level old_level;
+  bool ceiling;
+
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
-  if (thread_current()->waiting_on_lock == lock)
-    thread_current()->waiting_on_lock = NULL;
 
-  if (lock->holder != NULL)
-  {
-    remove_lock_donations(lock);
-    refresh_priority();
-  }
+  ceiling = lock->ceiling >= 0;
+
+  old_level = intr_disable ();
+#ifdef LOCK_PROFILE
+  lock_profile_released(lock);
+#endif
+  held_locks_remove(lock->holder, lock);
   lock->holder = NULL;
+  lock->max_waiter_priority = -1;
+  refresh_priority();
   sema_up(&lock->semaphore);
+  intr_set_level (old_level);
+
+  /* Coming down from the ceiling, let through any thread that
+     became ready meanwhile and now outranks us. */
+  if (ceiling)
+    thread_yield_if_outranked();
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -261,20 +401,415 @@ bool lock_held_by_current_thread(const struct lock *lock)
   return lock->holder == thread_current();
 }
 
-/* One semaphore in a list. */
+/* Prints the lock classes that spent the most ticks waiting, if
+   this kernel was built with LOCK_PROFILE. */
+void lock_print_stats(void)
+{
+#ifdef LOCK_PROFILE
+  bool printed[LOCK_CLASS_MAX];
+  int i, n;
+
+  memset(printed, 0, sizeof printed);
+  printf("Locks: %d classes, top contended:\n", lock_class_cnt);
+  for (n = 0; n < LOCK_PRINT_MAX && n < lock_class_cnt; n++)
+  {
+    struct lock_class *c = NULL;
+    int best = -1;
+
+    /* Selection sort by total wait, then by contended count. */
+    for (i = 0; i < lock_class_cnt; i++)
+      if (!printed[i]
+          && (c == NULL || lock_classes[i].wait_ticks > c->wait_ticks
+              || (lock_classes[i].wait_ticks == c->wait_ticks
+                  && lock_classes[i].contended > c->contended)))
+      {
+        c = &lock_classes[i];
+        best = i;
+      }
+    printed[best] = true;
+    if (c->contended == 0)
+      break;
+    printf("  %s: %u acquired, %u contended, %lld ticks waited "
+           "(max %lld), held at most %lld ticks\n",
+           c->name, c->acquisitions, c->contended, c->wait_ticks,
+           c->max_wait_ticks, c->max_hold_ticks);
+  }
+#endif
+}
+
+#ifdef LOCK_PROFILE
+/* Returns the lock class for NAME, creating it if necessary, or
+   a null pointer if the class table is full. */
+struct lock_class *
+lock_class_lookup(const char *name)
+{
+  struct lock_class *c;
+  enum intr_level old_level;
+  int i;
+
+  old_level = intr_disable();
+  for (i = 0; i < lock_class_cnt; i++)
+    if (!strcmp(lock_classes[i].name, name))
+    {
+      intr_set_level(old_level);
+      return &lock_classes[i];
+    }
+
+  c = NULL;
+  if (lock_class_cnt < LOCK_CLASS_MAX)
+  {
+    c = &lock_classes[lock_class_cnt++];
+    c->name = name;
+  }
+  intr_set_level(old_level);
+  return c;
+}
+
+/* Accounts in class C, which may be null, for an acquisition by
+   a thread that started to try at tick WAIT_START and had to wait
+   if CONTENDED.  Returns the current tick.  Must be called with
+   interrupts off. */
+static int64_t
+lock_class_acquired(struct lock_class *c, bool contended, int64_t wait_start)
+{
+  int64_t now = timer_ticks();
+
+  if (c == NULL)
+    return now;
+  c->acquisitions++;
+  if (contended)
+  {
+    int64_t waited = now - wait_start;
+
+    c->contended++;
+    c->wait_ticks += waited;
+    if (waited > c->max_wait_ticks)
+      c->max_wait_ticks = waited;
+  }
+  return now;
+}
+
+/* Accounts in class C, which may be null, for a release of a lock
+   held since tick ACQUIRED_AT.  Must be called with interrupts
+   off. */
+static void
+lock_class_released(struct lock_class *c, int64_t acquired_at)
+{
+  int64_t held = timer_ticks() - acquired_at;
+
+  if (c != NULL && held > c->max_hold_ticks)
+    c->max_hold_ticks = held;
+}
+
+/* Accounts for the current thread acquiring LOCK, having started
+   to try at tick WAIT_START and having had to wait if CONTENDED.
+   Must be called with interrupts off. */
+static void
+lock_profile_acquired(struct lock *lock, bool contended, int64_t wait_start)
+{
+  lock->acquired_at = lock_class_acquired(lock->class, contended,
+                                          wait_start);
+}
+
+/* Accounts for LOCK's holder releasing it.  Must be called with
+   interrupts off. */
+static void
+lock_profile_released(struct lock *lock)
+{
+  lock_class_released(lock->class, lock->acquired_at);
+}
+
+/* Accounts for the current thread acquiring spinlock L, having
+   started to try at tick WAIT_START and having had to spin if
+   CONTENDED.  Must be called with interrupts off. */
+void
+spinlock_profile_acquired(struct spinlock *l, bool contended,
+                          int64_t wait_start)
+{
+  l->acquired_at = lock_class_acquired(l->class, contended, wait_start);
+}
+
+/* Accounts for spinlock L's holder releasing it.  Must be called
+   with interrupts off. */
+void
+spinlock_profile_released(struct spinlock *l)
+{
+  lock_class_released(l->class, l->acquired_at);
+}
+
+/* Accounts for the current thread acquiring RW in either mode,
+   having started to try at tick WAIT_START and having had to wait
+   if CONTENDED.  Must be called with interrupts off. */
+static void
+rwlock_profile_acquired(struct rwlock *rw, bool contended,
+                        int64_t wait_start)
+{
+  lock_class_acquired(rw->class, contended, wait_start);
+}
+
+/* Starts timing RW's hold if the holder just added is its first.
+   A hold in shared mode lasts from the first reader in to the
+   last reader out.  Must be called with interrupts off. */
+static void
+rwlock_profile_held(struct rwlock *rw)
+{
+  if (rw->writer != NULL || rw->reader_cnt == 1)
+    rw->acquired_at = timer_ticks();
+}
+#endif
+
+/* Initializes RW as a reader-writer lock held by no one, named
+   NAME for lock profiling, as with lock_init_named().
+
+   A reader-writer lock lets any number of threads, up to
+   RWLOCK_READERS_MAX, hold it at once in shared ("read") mode,
+   or exactly one thread hold it in exclusive ("write") mode.
+   Like a lock, it is not recursive, and the thread that acquires
+   it must be the one to release it.
+
+   Waiting threads are kept by priority in one heap per mode, and
+   ownership is handed directly to them on release.  A reader is
+   admitted past a held shared lock only if no waiting writer or
+   reader has at least its priority, so a stream of readers cannot
+   starve a writer of equal or higher priority.  A thread that
+   waits donates its priority to the writer or to every reader
+   holding the lock, and through them along chains of locks they
+   are in turn waiting for. */
+void rwlock_init_named(struct rwlock *rw, const char *name UNUSED)
+{
+  ASSERT(rw != NULL);
+
+  rw->writer = NULL;
+  rw->reader_cnt = 0;
+  heap_init(&rw->read_waiters, sema_waiter_less, NULL);
+  heap_init(&rw->write_waiters, sema_waiter_less, NULL);
+  rw->max_waiter_priority = -1;
+#ifdef LOCK_PROFILE
+  rw->class = lock_class_lookup(name);
+  rw->acquired_at = 0;
+#endif
+}
+
+/* Acquires RW in shared mode, sleeping until that is possible if
+   necessary.  RW must not already be held by the current thread.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rwlock_acquire_read(struct rwlock *rw)
+{
+  struct thread *cur = thread_current();
+  enum intr_level old_level;
+  bool contended;
+#ifdef LOCK_PROFILE
+  int64_t wait_start = timer_ticks();
+#endif
+
+  ASSERT(rw != NULL);
+  ASSERT(!intr_context());
+  ASSERT(!rwlock_held_by_current_thread(rw));
+
+  old_level = intr_disable();
+  contended = (rw->writer != NULL || rw->reader_cnt >= RWLOCK_READERS_MAX
+               || waiters_max_priority(&rw->write_waiters) >= cur->priority
+               || waiters_max_priority(&rw->read_waiters) >= cur->priority);
+  if (contended)
+    rwlock_wait(rw, &rw->read_waiters);
+  else
+  {
+    rw->readers[rw->reader_cnt++] = cur;
+    held_rwlocks_insert(cur, rw);
+#ifdef LOCK_PROFILE
+    rwlock_profile_held(rw);
+#endif
+  }
+#ifdef LOCK_PROFILE
+  rwlock_profile_acquired(rw, contended, wait_start);
+#endif
+  refresh_priority();
+  intr_set_level(old_level);
+}
+
+/* Releases RW, which the current thread must hold in shared
+   mode. */
+void rwlock_release_read(struct rwlock *rw)
+{
+  struct thread *cur = thread_current();
+  enum intr_level old_level;
+  int i;
+
+  ASSERT(rw != NULL);
+  ASSERT(!intr_context());
+
+  old_level = intr_disable();
+  for (i = 0; i < rw->reader_cnt; i++)
+    if (rw->readers[i] == cur)
+      break;
+  ASSERT(i < rw->reader_cnt);
+  rw->readers[i] = rw->readers[--rw->reader_cnt];
+  held_rwlocks_remove(cur, rw);
+#ifdef LOCK_PROFILE
+  if (rw->reader_cnt == 0)
+    lock_class_released(rw->class, rw->acquired_at);
+#endif
+  refresh_priority();
+  rwlock_grant(rw);
+  intr_set_level(old_level);
+}
+
+/* Acquires RW in exclusive mode, sleeping until it is free if
+   necessary.  RW must not already be held by the current thread.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rwlock_acquire_write(struct rwlock *rw)
+{
+  struct thread *cur = thread_current();
+  enum intr_level old_level;
+  bool contended;
+#ifdef LOCK_PROFILE
+  int64_t wait_start = timer_ticks();
+#endif
+
+  ASSERT(rw != NULL);
+  ASSERT(!intr_context());
+  ASSERT(!rwlock_held_by_current_thread(rw));
+
+  old_level = intr_disable();
+  contended = rw->writer != NULL || rw->reader_cnt > 0;
+  if (contended)
+    rwlock_wait(rw, &rw->write_waiters);
+  else
+  {
+    rw->writer = cur;
+    held_rwlocks_insert(cur, rw);
+#ifdef LOCK_PROFILE
+    rwlock_profile_held(rw);
+#endif
+  }
+#ifdef LOCK_PROFILE
+  rwlock_profile_acquired(rw, contended, wait_start);
+#endif
+  refresh_priority();
+  intr_set_level(old_level);
+}
+
+/* Releases RW, which the current thread must hold in exclusive
+   mode. */
+void rwlock_release_write(struct rwlock *rw)
+{
+  enum intr_level old_level;
+
+  ASSERT(rw != NULL);
+  ASSERT(rw->writer == thread_current());
+
+  old_level = intr_disable();
+#ifdef LOCK_PROFILE
+  lock_class_released(rw->class, rw->acquired_at);
+#endif
+  rw->writer = NULL;
+  held_rwlocks_remove(thread_current(), rw);
+  refresh_priority();
+  rwlock_grant(rw);
+  intr_set_level(old_level);
+}
+
+/* Returns true if the current thread holds RW in either mode,
+   false otherwise. */
+bool rwlock_held_by_current_thread(const struct rwlock *rw)
+{
+  struct thread *cur = thread_current();
+  int i;
+
+  ASSERT(rw != NULL);
+
+  for (i = 0; i < cur->held_rwlock_cnt; i++)
+    if (cur->held_rwlocks[i] == rw)
+      return true;
+  return false;
+}
+
+/* Queues the running thread on WAITERS, one of RW's wait heaps,
+   donates its priority to RW's holders, and sleeps until
+   rwlock_grant() has made it a holder.  Must be called with
+   interrupts off. */
+static void
+rwlock_wait(struct rwlock *rw, struct heap *waiters)
+{
+  struct thread *cur = thread_current();
+
+  heap_insert(waiters, &cur->wait_elem);
+  cur->wait_heap = waiters;
+  cur->wait_heap_elem = &cur->wait_elem;
+  cur->waiting_on_rwlock = rw;
+  if (!thread_mlfqs && !thread_cfs)
+    donate_to_rwlock(rw, cur->priority, 0);
+  thread_block();
+}
+
+/* Hands RW to as many waiting threads as its state allows: to
+   the highest-priority waiting writer once RW is free, otherwise
+   to waiting readers that outrank every waiting writer.  A
+   writer wins ties.  Each thread is made a holder before it is
+   woken, so it never has to compete for RW again.  Must be
+   called with interrupts off. */
+static void
+rwlock_grant(struct rwlock *rw)
+{
+  while (rw->writer == NULL)
+  {
+    int write_priority = waiters_max_priority(&rw->write_waiters);
+    int read_priority = waiters_max_priority(&rw->read_waiters);
+    struct heap *waiters;
+    struct thread *t;
+
+    if (write_priority >= 0 && write_priority >= read_priority)
+    {
+      if (rw->reader_cnt > 0)
+        break;
+      waiters = &rw->write_waiters;
+      t = heap_entry(heap_pop(waiters), struct thread, wait_elem);
+      rw->writer = t;
+    }
+    else if (read_priority >= 0 && rw->reader_cnt < RWLOCK_READERS_MAX)
+    {
+      waiters = &rw->read_waiters;
+      t = heap_entry(heap_pop(waiters), struct thread, wait_elem);
+      rw->readers[rw->reader_cnt++] = t;
+    }
+    else
+      break;
+
+    if (t->wait_heap == waiters)
+      t->wait_heap = NULL;
+    t->waiting_on_rwlock = NULL;
+    held_rwlocks_insert(t, rw);
+#ifdef LOCK_PROFILE
+    rwlock_profile_held(rw);
+#endif
+    thread_unblock(t);
+  }
+
+  rw->max_waiter_priority = waiters_max_priority(&rw->write_waiters);
+  if (waiters_max_priority(&rw->read_waiters) > rw->max_waiter_priority)
+    rw->max_waiter_priority = waiters_max_priority(&rw->read_waiters);
+}
+
+/* One semaphore in a condition's waiter heap. */
 struct semaphore_elem 
   {
-    struct list_elem elem;              /* List element. */
+    struct heap_elem elem;              /* Heap element. */
     struct semaphore semaphore;         /* This semaphore. */
-    int elem_priority;
+    struct thread *thread;              /* Thread waiting on it. */
   };
 
-bool
-priority_less_cond(struct list_elem* a, struct list_elem* b, void* aux)
+/* Orders a condition's waiters by the current priority of the
+   waiting thread. */
+static bool
+cond_waiter_less(const struct heap_elem *a, const struct heap_elem *b,
+                 void *aux UNUSED)
 {
-  struct semaphore_elem* elem_a = list_entry(a, struct semaphore_elem, elem);
-  struct semaphore_elem* elem_b = list_entry(b, struct semaphore_elem, elem);
-  return elem_a->elem_priority >= elem_b->elem_priority;
+  return heap_entry(a, struct semaphore_elem, elem)->thread->priority
+         < heap_entry(b, struct semaphore_elem, elem)->thread->priority;
 }
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
@@ -283,7 +818,7 @@ void cond_init(struct condition *cond)
 {
   ASSERT(cond != NULL);
 
-  list_init(&cond->waiters);
+  heap_init(&cond->waiters, cond_waiter_less, NULL);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -309,15 +844,21 @@ void cond_init(struct condition *cond)
 void cond_wait(struct condition *cond, struct lock *lock)
 {
   struct semaphore_elem waiter;
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
 
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (lock_held_by_current_thread (lock));
   
-  waiter.elem_priority = thread_current ()->priority;
+  waiter.thread = cur;
   sema_init (&waiter.semaphore, 0);
-  list_insert_ordered(&cond->waiters, &waiter.elem, priority_less_cond, NULL);
+  old_level = intr_disable ();
+  heap_insert (&cond->waiters, &waiter.elem);
+  cur->wait_heap = &cond->waiters;
+  cur->wait_heap_elem = &waiter.elem;
+  intr_set_level (old_level);
   lock_release (lock);
   sema_down (&waiter.semaphore);
   lock_acquire (lock);
@@ -337,10 +878,14 @@ void cond_signal(struct condition *cond, struct lock *lock UNUSED)
   ASSERT(!intr_context());
   ASSERT(lock_held_by_current_thread(lock));
 
-  if (!list_empty (&cond->waiters)) 
+  if (!heap_empty (&cond->waiters)) 
   {
-    struct semaphore_elem* waiting_elem = list_entry (list_pop_front (&cond->waiters),struct semaphore_elem, elem);
+    enum intr_level old_level = intr_disable ();
+    struct semaphore_elem* waiting_elem = heap_entry (heap_pop (&cond->waiters), struct semaphore_elem, elem);
+    if (waiting_elem->thread->wait_heap == &cond->waiters)
+      waiting_elem->thread->wait_heap = NULL;
     sema_up (&waiting_elem->semaphore);
+    intr_set_level (old_level);
   }
 }
 
@@ -355,62 +900,248 @@ void cond_broadcast(struct condition *cond, struct lock *lock)
   ASSERT(cond != NULL);
   ASSERT(lock != NULL);
 
-  while (!list_empty (&cond->waiters))
+  while (!heap_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
 
 
-void donate_priority(struct lock *lock) {
-  if (lock == NULL)
-      return;
-      
-  struct thread *holder = lock->holder;
-  if (holder == NULL)
-      return;
-      
-  struct thread *current = thread_current();
-  
-  if (current->priority > holder->priority) {
-      struct donation *d = malloc(sizeof(struct donation));
+/* Donates the running thread's priority, which is about to
+   block on LOCK, to LOCK's holder, and from there on along the
+   chain of locks that holders are themselves waiting on.  Must
+   be called with interrupts off. */
+void donate_priority(struct lock *lock)
+{
+  ASSERT(intr_get_level() == INTR_OFF);
 
-      d->priority = current->priority;
-      d->lock = lock;
-      list_push_back(&holder->donated_priorities, &d->elem);
+  if (thread_mlfqs || thread_cfs)
+    return;
 
-      holder->priority = current->priority;
-      
-      if (holder->waiting_on_lock != NULL) {
-          donate_priority(holder->waiting_on_lock);  // Recurse up the chain
-      }
-  }
+  donate_to_lock(lock, thread_current()->priority, 0);
 }
 
-void remove_lock_donations(struct lock *lock) {
-  struct thread *holder = lock->holder;
-  if (holder != NULL) {
-    struct list_elem *e = list_begin(&holder->donated_priorities);
-    while (e != list_end(&holder->donated_priorities)) {
-        struct donation *d = list_entry(e, struct donation, elem);
-        if (d->lock == lock) {
-            e = list_remove(e);
-        } else {
-            e = list_next(e);
-        }
-    }  
+/* Donates PRIORITY to LOCK's holder and onward.  Plain lock
+   chains are walked iteratively; the walk stops after
+   DONATION_DEPTH_MAX locks in all, or as soon as a holder already
+   runs at least as high.  Each step only re-keys LOCK in its
+   holder's held-lock heap, so donation never allocates. */
+static void
+donate_to_lock(struct lock *lock, int priority, int depth)
+{
+  for (; lock != NULL && depth < DONATION_DEPTH_MAX; depth++)
+  {
+    struct thread *holder = lock->holder;
+
+    if (holder == NULL || priority <= lock->max_waiter_priority)
+      break;
+    lock->max_waiter_priority = priority;
+    held_locks_sift_up(holder, lock->heap_index);
+
+    if (priority <= holder->priority)
+      break;
+    thread_change_priority(holder, priority);
+    trace_event(TRACE_DONATE, holder, thread_current()->tid);
+    if (holder->waiting_on_rwlock != NULL)
+    {
+      donate_to_rwlock(holder->waiting_on_rwlock, priority, depth + 1);
+      break;
+    }
+    lock = holder->waiting_on_lock;
   }
 }
 
-void refresh_priority(void) {
+/* Donates PRIORITY to every holder of RW, the writer or each
+   reader, and onward from each of them. */
+static void
+donate_to_rwlock(struct rwlock *rw, int priority, int depth)
+{
+  int i;
+
+  if (depth >= DONATION_DEPTH_MAX || priority <= rw->max_waiter_priority)
+    return;
+  rw->max_waiter_priority = priority;
+
+  if (rw->writer != NULL)
+    donate_to_holder(rw->writer, priority, depth);
+  for (i = 0; i < rw->reader_cnt; i++)
+    donate_to_holder(rw->readers[i], priority, depth);
+}
+
+/* Raises HOLDER, which holds a reader-writer lock, to PRIORITY
+   and passes the donation on to whatever HOLDER waits for. */
+static void
+donate_to_holder(struct thread *holder, int priority, int depth)
+{
+  if (priority <= holder->priority)
+    return;
+  thread_change_priority(holder, priority);
+  trace_event(TRACE_DONATE, holder, thread_current()->tid);
+  if (holder->waiting_on_lock != NULL)
+    donate_to_lock(holder->waiting_on_lock, priority, depth + 1);
+  else if (holder->waiting_on_rwlock != NULL)
+    donate_to_rwlock(holder->waiting_on_rwlock, priority, depth + 1);
+}
+
+/* Recomputes the running thread's priority as the higher of its
+   own priority and the priority donated through the locks it
+   holds, which is the key at the top of its held-lock heap, and
+   through the reader-writer locks it holds.  The change goes
+   through thread_change_priority(), because cond_wait() releases
+   its lock, and so perhaps a donation, after queuing the thread
+   on the condition by priority.  Must be called with interrupts
+   off. */
+void refresh_priority(void)
+{
   struct thread *t = thread_current();
+  int priority = t->original_priority;
+  int i;
 
-  int max_priority = t->original_priority;
-  struct list_elem *e = list_begin(&t->donated_priorities);
-  while (e != list_end(&t->donated_priorities)) {
-    struct donation *d = list_entry(e, struct donation, elem);
-    if (d->priority > max_priority) {
-      max_priority = d->priority;
-    }
-    e = list_next(e);
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (thread_mlfqs || thread_cfs)
+    return;
+
+  if (t->held_lock_cnt > 0 && t->held_locks[0]->max_waiter_priority > priority)
+    priority = t->held_locks[0]->max_waiter_priority;
+  for (i = 0; i < t->held_rwlock_cnt; i++)
+    if (t->held_rwlocks[i]->max_waiter_priority > priority)
+      priority = t->held_rwlocks[i]->max_waiter_priority;
+  thread_change_priority(t, priority);
+}
+
+/* Returns the priority that LOCK, just acquired, raises its
+   holder to: its ceiling, or for a lock without one, the highest
+   priority of the threads still waiting for it, or -1. */
+static int
+lock_raised_priority(struct lock *lock)
+{
+  if (lock->ceiling >= 0)
+    return lock->ceiling;
+  return sema_max_waiter_priority(&lock->semaphore);
+}
+
+/* Returns the highest priority among the threads waiting on
+   SEMA, or -1 if there are none. */
+static int
+sema_max_waiter_priority(struct semaphore *sema)
+{
+  return waiters_max_priority(&sema->waiters);
+}
+
+/* Returns the highest priority among the threads in WAITERS, a
+   heap of threads' wait_elem, or -1 if it is empty. */
+static int
+waiters_max_priority(struct heap *waiters)
+{
+  if (heap_empty(waiters))
+    return -1;
+  return heap_entry(heap_max(waiters), struct thread, wait_elem)->priority;
+}
+
+/* Held-lock heap.  Each thread keeps the locks it holds in
+   T->held_locks[] as a binary max-heap ordered by
+   max_waiter_priority, and each lock remembers its index in
+   heap_index, so re-keying or removing a lock is O(log k) in the
+   number of locks held. */
+
+/* Swaps the locks at heap positions I and J of T. */
+static void
+held_locks_swap(struct thread *t, int i, int j)
+{
+  struct lock *tmp = t->held_locks[i];
+  t->held_locks[i] = t->held_locks[j];
+  t->held_locks[j] = tmp;
+  t->held_locks[i]->heap_index = i;
+  t->held_locks[j]->heap_index = j;
+}
+
+/* Moves the lock at position I of T's heap up until its parent's
+   key is at least as large. */
+static void
+held_locks_sift_up(struct thread *t, int i)
+{
+  while (i > 0)
+  {
+    int parent = (i - 1) / 2;
+    if (t->held_locks[parent]->max_waiter_priority >= t->held_locks[i]->max_waiter_priority)
+      break;
+    held_locks_swap(t, i, parent);
+    i = parent;
   }
-  t->priority = max_priority;
-}
\ No newline at end of file
+}
+
+/* Moves the lock at position I of T's heap down until both of
+   its children have keys no larger than its own. */
+static void
+held_locks_sift_down(struct thread *t, int i)
+{
+  for (;;)
+  {
+    int left = 2 * i + 1;
+    int right = left + 1;
+    int max = i;
+
+    if (left < t->held_lock_cnt
+        && t->held_locks[left]->max_waiter_priority > t->held_locks[max]->max_waiter_priority)
+      max = left;
+    if (right < t->held_lock_cnt
+        && t->held_locks[right]->max_waiter_priority > t->held_locks[max]->max_waiter_priority)
+      max = right;
+    if (max == i)
+      break;
+    held_locks_swap(t, i, max);
+    i = max;
+  }
+}
+
+/* Adds LOCK to T's heap of held locks. */
+static void
+held_locks_insert(struct thread *t, struct lock *lock)
+{
+  ASSERT(t->held_lock_cnt < MAX_HELD_LOCKS);
+
+  lock->heap_index = t->held_lock_cnt++;
+  t->held_locks[lock->heap_index] = lock;
+  held_locks_sift_up(t, lock->heap_index);
+}
+
+/* Removes LOCK from T's heap of held locks. */
+static void
+held_locks_remove(struct thread *t, struct lock *lock)
+{
+  int i = lock->heap_index;
+
+  ASSERT(i >= 0 && i < t->held_lock_cnt && t->held_locks[i] == lock);
+
+  t->held_lock_cnt--;
+  if (i != t->held_lock_cnt)
+  {
+    held_locks_swap(t, i, t->held_lock_cnt);
+    held_locks_sift_up(t, i);
+    held_locks_sift_down(t, i);
+  }
+  lock->heap_index = -1;
+}
+
+/* Records that T holds RW. */
+static void
+held_rwlocks_insert(struct thread *t, struct rwlock *rw)
+{
+  ASSERT(t->held_rwlock_cnt < MAX_HELD_RWLOCKS);
+
+  t->held_rwlocks[t->held_rwlock_cnt++] = rw;
+}
+
+/* Records that T no longer holds RW. */
+static void
+held_rwlocks_remove(struct thread *t, struct rwlock *rw)
+{
+  int i;
+
+  for (i = 0; i < t->held_rwlock_cnt; i++)
+    if (t->held_rwlocks[i] == rw)
+    {
+      t->held_rwlocks[i] = t->held_rwlocks[--t->held_rwlock_cnt];
+      return;
+    }
+  NOT_REACHED();
+}
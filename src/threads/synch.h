@@ -1,20 +1,15 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
 
-struct donation {
-  int priority;
-  struct lock *lock;
-  struct list_elem elem;
-};
-
 /* A counting semaphore. */
 struct semaphore
 {
   unsigned value;      /* Current value. */
-  struct list waiters; /* List of waiting threads. */
+  struct heap waiters; /* Waiting threads, highest priority first. */
 };
 
 void sema_init(struct semaphore *, unsigned value);
@@ -28,30 +23,75 @@ struct lock
   {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
+    int max_waiter_priority;    /* Highest priority of any waiter, or -1. */
+    int heap_index;             /* Position in holder's held-lock heap. */
+    int ceiling;                /* Ceiling priority, or -1 to donate. */
+#ifdef LOCK_PROFILE
+    struct lock_class *class;   /* Statistics, or null if untracked. */
+    int64_t acquired_at;        /* Tick at which holder acquired us. */
+#endif
   };
-  struct donated_priority {
-    int priority;           // The donated priority value.
-    struct thread *donor;   // The thread that donated the priority.
-    struct list_elem elem;  // The list element (used to link the donated_priority struct in a list).
-};
-void lock_init (struct lock *);
+
+/* Initializes a lock named after the expression that names it,
+   e.g. "&fs_lock".  Use lock_init_named() to pick a better name;
+   locks with the same name share their statistics. */
+#define lock_init(LOCK) lock_init_named (LOCK, #LOCK)
+
+/* Likewise, for a lock that uses the priority ceiling protocol
+   with ceiling priority CEILING instead of priority donation. */
+#define lock_init_ceiling(LOCK, CEILING) \
+        lock_init_ceiling_named (LOCK, #LOCK, CEILING)
+
+void lock_init_named (struct lock *, const char *name);
+void lock_init_ceiling_named (struct lock *, const char *name, int ceiling);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
+void lock_print_stats (void);
+void donate_priority (struct lock *);
+void refresh_priority (void);
+
+/* Most threads that can share a reader-writer lock at once. */
+#define RWLOCK_READERS_MAX 8
+
+/* Reader-writer lock.  Held either by one writer, in exclusive
+   mode, or by up to RWLOCK_READERS_MAX readers, in shared mode. */
+struct rwlock
+  {
+    struct thread *writer;      /* Exclusive holder, or null. */
+    struct thread *readers[RWLOCK_READERS_MAX]; /* Shared holders. */
+    int reader_cnt;             /* # of shared holders. */
+    struct heap read_waiters;   /* Threads waiting for shared mode. */
+    struct heap write_waiters;  /* Threads waiting for exclusive mode. */
+    int max_waiter_priority;    /* Highest priority of any waiter, or -1. */
+#ifdef LOCK_PROFILE
+    struct lock_class *class;   /* Statistics, or null if untracked. */
+    int64_t acquired_at;        /* Tick at which RW stopped being free. */
+#endif
+  };
+
+/* Initializes a reader-writer lock named after the expression
+   that names it, as with lock_init(). */
+#define rwlock_init(RW) rwlock_init_named (RW, #RW)
+
+void rwlock_init_named (struct rwlock *, const char *name);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
 
 /* Condition variable. */
 struct condition 
   {
-    struct list waiters;        /* List of waiting threads. */
+    struct heap waiters;        /* Waiters, highest priority first. */
   };
 
 void cond_init (struct condition *);
 void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
-bool
-priority_less_cond(struct list_elem* a, struct list_elem* b, void* aux);
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
@@ -1,7 +1,9 @@
 #include "threads/thread.h"
 #include <debug.h>
+#include <limits.h>
 #include <stddef.h>
 #include <random.h>
+#include <round.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/flags.h"
@@ -10,9 +12,13 @@
 #include "threads/palloc.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
+#include "threads/tsc.h"
 #include "threads/vaddr.h"
+#include "threads/kmem.h"
 #include "threads/malloc.h"
 #include "threads/fixedPoint.h"
+#include "devices/timer.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
@@ -22,9 +28,32 @@
    of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running.  There is one FIFO
+   queue per priority level, and bit P of ready_bitmap is set
+   exactly when ready_queues[P] is non-empty, so the highest
+   runnable priority is found with a single bit scan.
+
+   Ready real-time threads within their budget are kept apart, in
+   rt_ready, and always run first, earliest deadline first.
+
+   Under the completely fair scheduler the priority queues are
+   unused.  Ready threads are kept in cfs_tree instead, ordered by
+   vruntime, and the thread that has had the least weighted CPU
+   time runs next. */
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_bitmap;
+static int ready_cnt;          /* Total # of ready threads. */
+static struct rbtree cfs_tree;
+static uint64_t min_vruntime;  /* Floor for vruntime of wakers. */
+static struct heap rt_ready;
+
+/* Pages of dead threads kept for reuse, which spares
+   thread_create() a trip through the page allocator and a 4 kB
+   memset. */
+#define THREAD_CACHE_MAX 8
+static void *thread_cache[THREAD_CACHE_MAX];
+static int thread_cache_cnt;
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
@@ -39,15 +68,98 @@ static struct thread *initial_thread;
 /* Lock used by allocate_tid(). */
 static struct lock tid_lock;
 
-/* List of sleeping threads */
-static struct list sleep_list;
+/* Cache of struct child_record, one of which is allocated for
+   every thread created. */
+static struct kmem_cache record_cache =
+    KMEM_CACHE_INITIALIZER("child_record", sizeof(struct child_record),
+                           __alignof__(struct child_record), NULL);
+
+/* Sleeping threads, kept in a hierarchical timing wheel.  Level
+   L has WHEEL_SIZE slots, each covering 2**(WHEEL_BITS * L)
+   ticks, so a sleeper is filed in O(1) under the coarsest level
+   whose span still separates its wake_tick from now.  Whenever
+   the low bits of the current tick roll over, the matching slot
+   of the next level up is cascaded down one level, and the
+   level-0 slot for the current tick holds exactly the threads
+   that are due.  Sleeps longer than the whole wheel are parked in
+   the last slot reachable at the top level and refiled when that
+   slot is cascaded. */
+#define WHEEL_BITS 6                      /* log2 of slots per level. */
+#define WHEEL_SIZE (1 << WHEEL_BITS)      /* Slots per level. */
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 4                    /* Spans 2**24 ticks. */
+#define WHEEL_SPAN ((int64_t) 1 << (WHEEL_BITS * WHEEL_LEVELS))
+static struct list sleep_wheel[WHEEL_LEVELS][WHEEL_SIZE];
+static int64_t wheel_now;   /* Last tick processed by the wheel. */
+static int sleeper_cnt;     /* # of threads in the wheel. */
 
 /*---------Added---------------*/
 #define NICE_MAX 20
 #define NICE_MIN -20
 static fixed_point load_avg; /* Load average. */
+
+/* Kernel helper threads left out of load_avg; see
+   thread_exclude_from_load(). */
+#define LOAD_EXEMPT_MAX 4
+static struct thread *load_exempt[LOAD_EXEMPT_MAX];
+static int load_exempt_cnt;
+
+/* Once a second, recent_cpu decays by 2*load_avg/(2*load_avg+1)
+   for every thread.  The decay pass only touches runnable
+   threads; a blocked thread catches up on the passes it missed
+   when it is unblocked, using the coefficients remembered here.
+   Pass number N stores its coefficient at
+   decay_history[N % DECAY_HISTORY].
+
+   A thread blocked for more than DECAY_HISTORY passes is treated
+   as fully decayed at the start of the window: its recent_cpu
+   restarts from 0 and only the last DECAY_HISTORY passes are
+   replayed.  The term dropped is the old recent_cpu times the
+   product of DECAY_HISTORY coefficients.  Each coefficient is
+   below 2/3 while load_avg stays under 1, making the product
+   less than 2**-37, far below the 2**-14 fixed-point
+   resolution; at a load_avg of 8 it is still only about 2%. */
+#define DECAY_HISTORY 64          /* Power of 2. */
+static fixed_point decay_history[DECAY_HISTORY];
+static unsigned decay_passes;     /* # of decay passes so far. */
 /*---------Added---------------*/
 
+/* Completely fair scheduler.  A running thread's vruntime grows
+   by CFS_TICK_SCALE * NICE_0_WEIGHT / weight per timer tick, so
+   a nice 0 thread gains CFS_TICK_SCALE per tick and the others
+   proportionally more or less.  Only the running thread is
+   updated, once per tick.  It is preempted once it is more than
+   CFS_GRANULARITY ahead of the least vruntime in the run tree. */
+#define NICE_0_WEIGHT 1024
+#define CFS_TICK_SCALE 1024
+#define CFS_GRANULARITY (2 * CFS_TICK_SCALE)
+#define CFS_SLEEPER_CREDIT (TIME_SLICE * CFS_TICK_SCALE)
+
+/* Weight of each nice value from NICE_MIN to NICE_MAX.  Each step
+   of nice changes the share of CPU by about 10% relative to a
+   competing thread, as in Linux. */
+static const uint32_t cfs_weights[NICE_MAX - NICE_MIN + 1] = {
+  /* -20 */ 88761, 71755, 56483, 46273, 36291,
+  /* -15 */ 29154, 23254, 18705, 14949, 11916,
+  /* -10 */ 9548, 7620, 6100, 4904, 3906,
+  /*  -5 */ 3121, 2501, 1991, 1586, 1277,
+  /*   0 */ 1024, 820, 655, 526, 423,
+  /*   5 */ 335, 272, 215, 172, 137,
+  /*  10 */ 110, 87, 70, 56, 45,
+  /*  15 */ 36, 29, 23, 18, 15,
+  /*  20 */ 12,
+};
+
+/* Real-time class.  A reservation is admitted only while the
+   densities, budget / deadline, of all reservations sum to at
+   most RT_DENSITY_MAX / RT_DENSITY_SCALE, which is enough for EDF
+   to meet every deadline of threads that stay within budget and
+   still leaves some CPU time to everything else.  Protected by
+   disabling interrupts. */
+#define RT_DENSITY_SCALE 1000
+#define RT_DENSITY_MAX 950
+static int rt_density;            /* Sum of admitted densities. */
+
 /* Stack frame for kernel_thread(). */
 struct kernel_thread_frame 
 {
@@ -61,6 +173,23 @@ static long long idle_ticks;   /* # of timer ticks spent idle. */
 static long long kernel_ticks; /* # of timer ticks in kernel threads. */
 static long long user_ticks;   /* # of timer ticks in user programs. */
 
+/* Wakeup latency: TSC cycles from thread_unblock() until the
+   thread runs, in log2 buckets per scheduler mode and per band of
+   LATENCY_BAND_WIDTH priorities.  Bucket B counts latencies in
+   [2**B, 2**(B+1)). */
+enum sched_mode
+{
+	SCHED_PRIORITY,             /* Priority scheduler (default). */
+	SCHED_MLFQS,                /* Advanced scheduler, "-mlfqs". */
+	SCHED_CFS,                  /* Completely fair scheduler, "-cfs". */
+	SCHED_MODE_CNT
+};
+static const char *sched_mode_names[SCHED_MODE_CNT] = {"priority", "mlfqs", "cfs"};
+#define LATENCY_BAND_WIDTH 8
+#define LATENCY_BANDS ((PRI_MAX + 1) / LATENCY_BAND_WIDTH)
+#define LATENCY_BUCKETS 48
+static unsigned wakeup_latency[SCHED_MODE_CNT][LATENCY_BANDS][LATENCY_BUCKETS];
+
 /* Scheduling. */
 #define TIME_SLICE 4          /* # of timer ticks to give each thread. */
 static unsigned thread_ticks; /* # of timer ticks since last yield. */
@@ -70,6 +199,10 @@ static unsigned thread_ticks; /* # of timer ticks since last yield. */
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* If true, use the completely fair scheduler.
+   Controlled by kernel command-line option "-o cfs". */
+bool thread_cfs;
+
 static void kernel_thread(thread_func *, void *aux);
 
 static void idle(void *aux UNUSED);
@@ -79,8 +212,26 @@ static void init_thread(struct thread *, const char *name, int priority);
 static bool is_thread(struct thread *) UNUSED;
 static void *alloc_frame(struct thread *, size_t size);
 static void schedule(void);
+static struct thread *thread_page_alloc(void);
+static void thread_page_free(struct thread *);
+static hash_hash_func child_record_hash;
+static hash_less_func child_record_less;
+static hash_action_func child_record_destroy;
+static void ready_queue_push(struct thread *);
+static void ready_queue_remove(struct thread *);
+static struct thread *ready_queue_pop(void);
+static rb_less_func vruntime_less;
+static heap_less_func deadline_less;
+static bool rt_active(const struct thread *);
+static uint64_t cfs_vruntime_delta(const struct thread *);
+static bool cfs_should_preempt(struct thread *);
 void thread_schedule_tail(struct thread *prev);
 static tid_t allocate_tid(void);
+static void sleep_wheel_insert(struct thread *);
+static int bit_scan_reverse(uint64_t);
+static int highest_ready_priority(uint64_t);
+static void record_wakeup_latency(struct thread *);
+static void print_wakeup_latency(void);
 
 /* Initializes the threading system by transforming the code
    that's currently running into a thread.  This can't work in
@@ -99,10 +250,23 @@ void thread_init(void)
 {
   ASSERT(intr_get_level() == INTR_OFF);
 
+  int i, j;
+
   lock_init(&tid_lock);
-  list_init(&ready_list);
+  for (i = PRI_MIN; i <= PRI_MAX; i++)
+    list_init(&ready_queues[i]);
+  ready_bitmap = 0;
+  ready_cnt = 0;
+  rb_init(&cfs_tree, vruntime_less, NULL);
+  min_vruntime = 0;
+  heap_init(&rt_ready, deadline_less, NULL);
+  thread_cache_cnt = 0;
   list_init(&all_list);
-  list_init(&sleep_list);
+  for (i = 0; i < WHEEL_LEVELS; i++)
+    for (j = 0; j < WHEEL_SIZE; j++)
+      list_init(&sleep_wheel[i][j]);
+  wheel_now = 0;
+  sleeper_cnt = 0;
   load_avg.value = 0;
 
   /* Set up a thread structure for the running thread. */
@@ -112,53 +276,113 @@ void thread_init(void)
   initial_thread->tid = allocate_tid();
 }
 
-/* Comparator function to sort list based on wake_tick */
-static bool
-sleep_list_less_compare(const struct list_elem *a,
-                        const struct list_elem *b,
-                        void *aux UNUSED)
+/* Files T in the sleep wheel according to T->wake_tick, which
+   must be later than wheel_now. */
+static void
+sleep_wheel_insert(struct thread *t)
 {
-  struct sleeping_thread *a_thread = list_entry(a, struct sleeping_thread, elem);
-  struct sleeping_thread *b_thread = list_entry(b, struct sleeping_thread, elem);
-  return a_thread->wake_tick < b_thread->wake_tick;
+  int64_t wake_tick = t->wake_tick;
+  int64_t delta = wake_tick - wheel_now;
+  int level;
+
+  ASSERT(delta > 0);
+
+  if (delta >= WHEEL_SPAN)
+    wake_tick = wheel_now + WHEEL_SPAN - 1;
+  for (level = 0; level < WHEEL_LEVELS - 1; level++)
+    if (delta < (int64_t) 1 << (WHEEL_BITS * (level + 1)))
+      break;
+  list_push_back(&sleep_wheel[level][(wake_tick >> (WHEEL_BITS * level)) & WHEEL_MASK],
+                 &t->elem);
 }
 
-/* Adds a thread to the sleep list and blocks it
-  This function must be called with interrupts off.
-*/
+/* Puts the current thread to sleep until timer tick WAKE_TICK.
+   Returns immediately if WAKE_TICK has already passed.
+   This function must be called with interrupts off. */
 void thread_sleep(int64_t wake_tick)
 {
-  struct sleeping_thread *sleeping_thread;
-
-  ASSERT(!intr_context());             // checks if no interrupt is being processed
-  ASSERT(intr_get_level() == INTR_OFF) // checks if interrupts are off
+  struct thread *cur = thread_current();
 
-  sleeping_thread = malloc(sizeof(struct sleeping_thread));
-  if (sleeping_thread == NULL)
-    PANIC("Failed to allocate memory for sleeping_thread");
+  ASSERT(!intr_context());
+  ASSERT(intr_get_level() == INTR_OFF);
 
-  sleeping_thread->thread = thread_current();
-  sleeping_thread->wake_tick = wake_tick;
+  if (wake_tick <= wheel_now)
+    return;
 
-  list_insert_ordered(&sleep_list, &sleeping_thread->elem, sleep_list_less_compare, NULL);
+  cur->wake_tick = wake_tick;
+  sleep_wheel_insert(cur);
+  sleeper_cnt++;
+  trace_event(TRACE_SLEEP, cur, wake_tick);
   thread_block();
 }
 
-/* Wakes up a sleeping thread if the current time is greater than or equal to the wake_tick */
+/* Returns the earliest tick at which the sleep wheel may have a
+   thread to wake, or INT64_MAX if no thread is sleeping.  The
+   answer is exact when a due thread is already in level 0, and
+   otherwise conservatively the next cascade point.  Must be
+   called with interrupts off. */
+int64_t thread_next_wake_tick(void)
+{
+  int64_t tick;
+
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (sleeper_cnt == 0)
+    return INT64_MAX;
+  for (tick = wheel_now + 1;; tick++)
+    if ((tick & WHEEL_MASK) == 0 || !list_empty(&sleep_wheel[0][tick & WHEEL_MASK]))
+      return tick;
+}
+
+/* Advances the sleep wheel to CURRENT_TICK, waking every thread
+   whose wake_tick has been reached.  Called from the timer
+   interrupt handler. */
 void thread_wake_sleeping_threads(int64_t current_tick)
 {
-  struct list_elem *e;
+  if (sleeper_cnt == 0)
+  {
+    wheel_now = current_tick;
+    return;
+  }
 
-  while (!list_empty(&sleep_list))
+  while (wheel_now < current_tick)
   {
-    e = list_front(&sleep_list);
-    struct sleeping_thread *sleeping_thread = list_entry(e, struct sleeping_thread, elem);
-    // if we have not reached the minimum wake_tick then break
-    if (current_tick < sleeping_thread->wake_tick)
-      break;
+    int64_t now = ++wheel_now;
+    struct list *slot;
+    int level;
+
+    /* Cascade each level whose lower levels just wrapped. */
+    for (level = 1; level < WHEEL_LEVELS; level++)
+    {
+      struct list refile;
+
+      if ((now & (((int64_t) 1 << (WHEEL_BITS * level)) - 1)) != 0)
+        break;
+
+      slot = &sleep_wheel[level][(now >> (WHEEL_BITS * level)) & WHEEL_MASK];
+      list_init(&refile);
+      while (!list_empty(slot))
+        list_push_back(&refile, list_pop_front(slot));
+      while (!list_empty(&refile))
+      {
+        struct thread *t = list_entry(list_pop_front(&refile), struct thread, elem);
+        if (t->wake_tick <= now)
+          list_push_back(&sleep_wheel[0][now & WHEEL_MASK], &t->elem);
+        else
+          sleep_wheel_insert(t);
+      }
+    }
 
-    list_remove(e);
-    thread_unblock(sleeping_thread->thread);
+    /* Everything left in this level-0 slot is due now. */
+    slot = &sleep_wheel[0][now & WHEEL_MASK];
+    while (!list_empty(slot))
+    {
+      struct thread *t = list_entry(list_pop_front(slot), struct thread, elem);
+      ASSERT(t->wake_tick <= now);
+      sleeper_cnt--;
+      trace_event(TRACE_WAKE, t, 0);
+      thread_unblock(t);
+    }
   }
 }
 
@@ -168,6 +392,12 @@ void thread_start(void)
 {
 	/* Create the idle thread. */
 	struct semaphore idle_started;
+
+  /* The main thread's children could not be set up in
+     thread_init(), before malloc() was available. */
+  if (!hash_init(&initial_thread->children, child_record_hash, child_record_less, NULL))
+    PANIC("out of memory for the main thread's children");
+
 	sema_init (&idle_started, 0);
 	thread_create ("idle", PRI_MIN, idle, &idle_started, NULL);
 
@@ -179,31 +409,121 @@ void thread_start(void)
 }
 
 /* Called by the timer interrupt handler at each timer tick.
-   Thus, this function runs in an external interrupt context. */
-void thread_tick(void)
+   USER is true if the tick interrupted user code.  Thus, this
+   function runs in an external interrupt context. */
+void thread_tick(bool user)
 {
   struct thread *t = thread_current();
 
 	/* Update statistics. */
 	if (t == idle_thread)
 		idle_ticks++;
-#ifdef USERPROG
-	else if (t->pagedir != NULL)
+	else if (user)
+	{
 		user_ticks++;
-#endif
+		t->usage.user_ticks++;
+	}
 	else
+	{
 		kernel_ticks++;
+		t->usage.kernel_ticks++;
+	}
 
-  /* Enforce preemption. */
-  if (++thread_ticks >= TIME_SLICE)
+  /* Enforce preemption.  A real-time thread is not time sliced,
+     but a job that spends its budget drops to the normal class
+     until it ends. */
+  if (rt_active(t))
+  {
+    if (++t->rt.used >= t->rt.budget)
+      intr_yield_on_return();
+  }
+  else if (thread_cfs)
+  {
+    if (t != idle_thread)
+      t->vruntime += cfs_vruntime_delta(t);
+    if (cfs_should_preempt(t))
+      intr_yield_on_return();
+  }
+  else if (++thread_ticks >= TIME_SLICE)
     intr_yield_on_return();
 }
 
+/* Returns how much one timer tick of CPU time advances the
+   vruntime of T, according to T's nice value. */
+static uint64_t
+cfs_vruntime_delta(const struct thread *t)
+{
+  return CFS_TICK_SCALE * NICE_0_WEIGHT / cfs_weights[t->nice - NICE_MIN];
+}
+
+/* Returns true if running thread T should give way to the
+   leftmost thread in the run tree, because T has run more than
+   CFS_GRANULARITY past it.  The idle thread always gives way. */
+static bool
+cfs_should_preempt(struct thread *t)
+{
+  struct rb_elem *e = rb_min(&cfs_tree);
+
+  if (e == NULL)
+    return false;
+  return t == idle_thread
+         || t->vruntime > rb_entry(e, struct thread, run_node)->vruntime + CFS_GRANULARITY;
+}
+
 /* Prints thread statistics. */
 void thread_print_stats(void)
 {
   printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
          idle_ticks, kernel_ticks, user_ticks);
+  print_wakeup_latency();
+}
+
+/* Prints the non-empty wakeup latency histograms, one line per
+   priority band, as "LOG2:COUNT" pairs. */
+static void
+print_wakeup_latency(void)
+{
+  int mode, band, b;
+
+  for (mode = 0; mode < SCHED_MODE_CNT; mode++)
+    for (band = LATENCY_BANDS - 1; band >= 0; band--)
+    {
+      unsigned *hist = wakeup_latency[mode][band];
+      unsigned total = 0;
+
+      for (b = 0; b < LATENCY_BUCKETS; b++)
+        total += hist[b];
+      if (total == 0)
+        continue;
+
+      printf("Wakeup latency (%s, priority %d-%d): %u wakeups, log2(cycles):",
+             sched_mode_names[mode], band * LATENCY_BAND_WIDTH,
+             (band + 1) * LATENCY_BAND_WIDTH - 1, total);
+      for (b = 0; b < LATENCY_BUCKETS; b++)
+        if (hist[b] != 0)
+          printf(" %d:%u", b, hist[b]);
+      printf("\n");
+    }
+}
+
+/* Adds the time since T was unblocked, if it was, to the wakeup
+   latency histograms, now that T is about to run. */
+static void
+record_wakeup_latency(struct thread *t)
+{
+  uint64_t cycles;
+  int bucket;
+
+  if (t->ready_tsc == 0)
+    return;
+  cycles = rdtsc() - t->ready_tsc;
+  t->ready_tsc = 0;
+
+  bucket = cycles != 0 ? bit_scan_reverse(cycles) : 0;
+  if (bucket >= LATENCY_BUCKETS)
+    bucket = LATENCY_BUCKETS - 1;
+  wakeup_latency[thread_cfs ? SCHED_CFS : thread_mlfqs ? SCHED_MLFQS : SCHED_PRIORITY]
+                [t->priority / LATENCY_BAND_WIDTH][bucket]++;
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -222,10 +542,11 @@ void thread_print_stats(void)
    PRIORITY, but no actual priority scheduling is implemented.
    Priority scheduling is the goal of Problem 1-3. */
 tid_t thread_create(const char *name, int priority,
-                    thread_func *function, void *aux)
+                    thread_func *function, void *aux, struct file *executable)
 {
 	struct thread *parent = thread_current();
 	struct thread *t;
+	struct child_record *record;
 	struct kernel_thread_frame *kf;
 	struct switch_entry_frame *ef;
 	struct switch_threads_frame *sf;
@@ -235,13 +556,50 @@ tid_t thread_create(const char *name, int priority,
   ASSERT(function != NULL);
 
   /* Allocate thread. */
-  t = palloc_get_page(PAL_ZERO);
+  t = thread_page_alloc();
   if (t == NULL)
     return TID_ERROR;
 
+  /* Only user processes and their threads are ever waited for.
+     A kernel thread started by another kernel thread gets no exit
+     record, or records for the threads that the initial thread
+     starts would pile up, since it never exits to free them. */
+  record = NULL;
+  if (parent->process != NULL || executable != NULL)
+  {
+    record = kmem_cache_alloc(&record_cache);
+    if (record == NULL)
+    {
+      palloc_free_page(t);
+      return TID_ERROR;
+    }
+  }
+
 	/* Initialize thread. */
 	init_thread (t, name, priority);
+  if (!hash_init(&t->children, child_record_hash, child_record_less, NULL))
+  {
+    old_level = intr_disable();
+    list_remove(&t->allelem);
+    intr_set_level(old_level);
+    kmem_cache_free(&record_cache, record);
+    palloc_free_page(t);
+    return TID_ERROR;
+  }
 	tid = t->tid = allocate_tid ();
+
+  /* Link T to its parent through an exit record. */
+  if (record != NULL)
+  {
+    record->tid = tid;
+    record->exit_status = 0;
+    sema_init(&record->exited, 0);
+    record->ref_cnt = 2;
+    hash_insert(&parent->children, &record->elem);
+  }
+  t->record = record;
+  t->parent = parent;
+
 	/* Prepare thread for first run by initializing its stack.
      Do this atomically so intermediate values for the 'stack' 
      member cannot be observed. */
@@ -262,14 +620,6 @@ tid_t thread_create(const char *name, int priority,
 	sf->eip = switch_entry;
 	sf->ebp = 0;
 
-	t->files_cnt = SYSTEM_FILES;
-	// t->files = malloc(MAX_FILES_PER_PROCESS * sizeof(struct open_file*));
-
-	list_init(&t->files);
-	t->next_fd = SYSTEM_FILES;
-
-	list_push_back(&thread_current()->children, &t->child_elem);
-	t->parent = thread_current();
 	t->executable = executable;
 	intr_set_level (old_level);
 	/* Add to run queue. */
@@ -289,6 +639,7 @@ void thread_block(void)
 	ASSERT (intr_get_level () == INTR_OFF);
 
 	thread_current ()->status = THREAD_BLOCKED;
+	trace_event (TRACE_BLOCK, thread_current (), 0);
 	schedule ();
 }
 
@@ -310,16 +661,52 @@ void thread_unblock(struct thread *t)
   old_level = intr_disable();
   ASSERT(t->status == THREAD_BLOCKED);
   if (thread_mlfqs)
+  {
+    calculateRecentCpu(t);
     calculatePriority(t, NULL);
+  }
 
-  list_insert_ordered(&ready_list, &t->elem, priority_less, NULL); // insert the threads orderd based on the priority
+  if (thread_cfs)
+  {
+    /* Don't let a long sleep bank more than a little credit
+       against the threads that kept running. */
+    uint64_t floor = min_vruntime > CFS_SLEEPER_CREDIT
+                         ? min_vruntime - CFS_SLEEPER_CREDIT
+                         : 0;
+    if (t->vruntime < floor)
+      t->vruntime = floor;
+  }
+  ready_queue_push(t);
   t->status = THREAD_READY;
+  t->ready_tsc = rdtsc();
+  trace_event(TRACE_UNBLOCK, t, 0);
   intr_set_level(old_level);
 
   struct thread *cur = thread_current();
   char *idle_name = "idle";
-  if (strcmp(cur->name, idle_name) && t->priority > cur->priority && !intr_context())
-    thread_yield();
+  if (strcmp(cur->name, idle_name) && thread_preempts(t, cur))
+  {
+    /* From an interrupt, a real-time thread preempts on return
+       rather than waiting for the end of the time slice. */
+    if (!intr_context())
+      thread_yield();
+    else if (rt_active(t))
+      intr_yield_on_return();
+  }
+}
+
+/* Returns true if T, which has just become ready, should preempt
+   the running thread CUR.  Real-time threads within budget go
+   first, earliest deadline first, then the other threads as the
+   scheduler in use orders them. */
+bool thread_preempts(const struct thread *t, const struct thread *cur)
+{
+  if (rt_active(t) || rt_active(cur))
+    return rt_active(t)
+           && (!rt_active(cur) || t->rt.abs_deadline < cur->rt.abs_deadline);
+  if (thread_cfs)
+    return t->vruntime + CFS_GRANULARITY < cur->vruntime;
+  return t->priority > cur->priority;
 }
 
 /* Returns the name of the running thread. */
@@ -358,18 +745,31 @@ tid_t thread_tid(void)
    returns to the caller. */
 void thread_exit(void)
 {
+  struct thread *cur = thread_current();
+
   ASSERT(!intr_context());
 
 #ifdef USERPROG
   process_exit();
 #endif
 
+  /* Let go of our children's exit records, and publish our own
+     exit status to our parent. */
+  hash_destroy(&cur->children, child_record_destroy);
+  if (cur->record != NULL)
+  {
+    cur->record->exit_status = cur->exit_status;
+    sema_up(&cur->record->exited);
+    child_record_release(cur->record);
+  }
+
 	/* Remove thread from all threads list, set our status to dying,
      and schedule another process.  That process will destroy us
      when it calls thread_schedule_tail(). */
   intr_disable();
-  list_remove(&thread_current()->allelem);
-  thread_current()->status = THREAD_DYING;
+  rt_density -= cur->rt.density;
+  list_remove(&cur->allelem);
+  cur->status = THREAD_DYING;
   schedule();
   NOT_REACHED();
 }
@@ -385,12 +785,35 @@ void thread_yield(void)
 
   old_level = intr_disable();
   if (cur != idle_thread)
-    list_insert_ordered(&ready_list, &cur->elem, priority_less, NULL);
+    ready_queue_push(cur);
   cur->status = THREAD_READY;
   schedule();
   intr_set_level(old_level);
 }
 
+/* Yields the CPU if a ready thread now outranks the running
+   thread, as after the running thread gives up a raised priority.
+   Only the priority scheduler needs this; under the others
+   priorities are left alone or ignored. */
+void thread_yield_if_outranked(void)
+{
+  struct thread *cur = thread_current();
+  enum intr_level old_level;
+  bool outranked;
+
+  ASSERT(!intr_context());
+
+  if (thread_mlfqs || thread_cfs)
+    return;
+
+  old_level = intr_disable();
+  outranked = !rt_active(cur) && ready_bitmap != 0
+              && highest_ready_priority(ready_bitmap) > cur->priority;
+  intr_set_level(old_level);
+  if (outranked)
+    thread_yield();
+}
+
 /* Invoke function 'func' on all threads, passing along 'aux'.
    This function must be called with interrupts off. */
 void thread_foreach(thread_action_func *func, void *aux)
@@ -410,9 +833,10 @@ void thread_foreach(thread_action_func *func, void *aux)
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void thread_set_priority(int new_priority)
 {
-  if (thread_current()->priority == thread_current()->original_priority)
-    thread_current()->priority = new_priority;
+  enum intr_level old_level = intr_disable();
   thread_current()->original_priority = new_priority;
+  refresh_priority();
+  intr_set_level(old_level);
   thread_yield();
 }
 
@@ -427,13 +851,42 @@ int get_prority_of_a_thread(struct thread *t)
   return t->priority;
 }
 
+/* Changes T's effective priority to PRIORITY.  If T is sitting
+   in the ready queues it is moved to the tail of the queue for
+   its new priority, and if it is in a priority-ordered wait queue
+   it is re-keyed there, so callers that donate to or recompute
+   the priority of a thread need not re-sort anything.
+   Must be called with interrupts off. */
+void thread_change_priority(struct thread *t, int priority)
+{
+  ASSERT(intr_get_level() == INTR_OFF);
+  ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
+
+  if (t->priority == priority)
+    return;
+  if (t->status == THREAD_READY && t != idle_thread)
+  {
+    ready_queue_remove(t);
+    t->priority = priority;
+    ready_queue_push(t);
+  }
+  else
+    t->priority = priority;
+  if (t->wait_heap != NULL)
+    heap_update(t->wait_heap, t->wait_heap_elem);
+}
+
 /* Sets the current thread's nice value to NICE. */
 void thread_set_nice(int nice UNUSED)
 {
+  enum intr_level old_level;
+
   ASSERT(nice <= NICE_MAX && nice >= NICE_MIN);
+  old_level = intr_disable();
   thread_current()->nice = nice;
-  calculatePriority(thread_current(), NULL);
-  list_sort(&ready_list, priority_less, NULL);
+  if (!thread_cfs)
+    calculatePriority(thread_current(), NULL);
+  intr_set_level(old_level);
   thread_yield();
 }
 
@@ -455,6 +908,120 @@ int thread_get_load_avg(void)
   return int_round(mult_fixed_by_int(load_avg, 100));
 }
 
+/* Leaves the running thread out of the count of ready threads
+   that load_avg averages.  Meant for kernel helper threads, such
+   as the work queue's worker, that run on behalf of other
+   threads: counting them would raise load_avg, and so slow the
+   decay of everyone's recent_cpu, whenever they have work.  The
+   running thread must never exit. */
+void thread_exclude_from_load(void)
+{
+  enum intr_level old_level = intr_disable();
+
+  ASSERT(load_exempt_cnt < LOAD_EXEMPT_MAX);
+  load_exempt[load_exempt_cnt++] = thread_current();
+  intr_set_level(old_level);
+}
+
+/* Makes the running thread real-time, releasing a job every
+   PERIOD ticks that needs at most BUDGET ticks of CPU time and
+   must finish within DEADLINE ticks of its release.  The first
+   job is released now.  Any earlier reservation of the thread is
+   replaced.  Returns false, leaving the thread unchanged, if the
+   reservation cannot be admitted alongside the existing ones.
+
+   A real-time thread is not protected by priority donation, so
+   it should not share locks with threads outside the class. */
+bool thread_set_realtime(int64_t period, int64_t budget, int64_t deadline)
+{
+  struct rt_params *rt = &thread_current()->rt;
+  enum intr_level old_level;
+  int density;
+
+  ASSERT(0 < budget && budget <= deadline && deadline <= period);
+
+  density = DIV_ROUND_UP(budget * RT_DENSITY_SCALE, deadline);
+  old_level = intr_disable();
+  if (rt_density - rt->density + density > RT_DENSITY_MAX)
+  {
+    intr_set_level(old_level);
+    return false;
+  }
+  rt_density += density - rt->density;
+  rt->period = period;
+  rt->budget = budget;
+  rt->deadline = deadline;
+  rt->density = density;
+  rt->release = timer_ticks();
+  rt->abs_deadline = rt->release + deadline;
+  rt->used = 0;
+  rt->jobs = 1;
+  rt->misses = 0;
+  intr_set_level(old_level);
+  return true;
+}
+
+/* Returns the running thread to the normal scheduling class,
+   releasing its real-time reservation. */
+void thread_clear_realtime(void)
+{
+  struct rt_params *rt = &thread_current()->rt;
+  enum intr_level old_level;
+
+  old_level = intr_disable();
+  rt_density -= rt->density;
+  rt->period = 0;
+  rt->density = 0;
+  intr_set_level(old_level);
+  thread_yield();
+}
+
+/* Ends the running real-time thread's current job and waits for
+   the release of its next one.  A job that ends after its
+   deadline counts as a miss.  Releases whose deadline has already
+   passed by then are skipped, and count as misses too. */
+void thread_wait_next_period(void)
+{
+  struct rt_params *rt = &thread_current()->rt;
+  enum intr_level old_level;
+  int64_t now;
+
+  ASSERT(rt->period != 0);
+
+  old_level = intr_disable();
+  now = timer_ticks();
+  if (now > rt->abs_deadline)
+    rt->misses++;
+  for (rt->release += rt->period; rt->release + rt->deadline < now;
+       rt->release += rt->period)
+  {
+    rt->jobs++;
+    rt->misses++;
+  }
+  rt->jobs++;
+  rt->abs_deadline = rt->release + rt->deadline;
+  rt->used = 0;
+
+  /* A late job's successor is already released; requeue it under
+     its new deadline instead of sleeping. */
+  if (rt->release > now)
+    thread_sleep(rt->release);
+  else
+    thread_yield();
+  intr_set_level(old_level);
+}
+
+/* Stores in *JOBS and *MISSES the number of jobs the running
+   thread has released as a real-time thread, and how many of
+   them missed their deadline. */
+void thread_get_rt_stats(unsigned *jobs, unsigned *misses)
+{
+  struct rt_params *rt = &thread_current()->rt;
+
+  *jobs = rt->jobs;
+  *misses = rt->misses;
+}
+
 /*---------Modefied---------------*/
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -466,6 +1033,29 @@ int thread_get_load_avg(void)
    blocks.  After that, the idle thread never appears in the
    ready list.  It is returned by next_thread_to_run() as a
    special case when the ready list is empty. */
+/* Returns how many timer ticks, counting the next one, may pass
+   before one of them has to be taken on time for the running
+   thread: 1 if another thread is ready, since any tick may
+   preempt in its favor; otherwise the ticks left in the running
+   thread's time slice or real-time budget, which bound how long
+   a thread that becomes ready later waits for its turn; or
+   INT_MAX for the idle thread.  Must be called with interrupts
+   off. */
+int thread_ticks_to_preempt(void)
+{
+  struct thread *t = thread_current();
+
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (ready_cnt > 0)
+    return 1;
+  if (t == idle_thread)
+    return INT_MAX;
+  if (rt_active(t))
+    return t->rt.budget - t->rt.used;
+  return TIME_SLICE - thread_ticks;
+}
+
 static void
 idle(void *idle_started_ UNUSED)
 {
@@ -529,7 +1119,8 @@ is_thread(struct thread *t)
 }
 
 /* Does basic initialization of T as a blocked thread named
-   NAME. */
+   NAME.  Only struct thread itself is cleared; the rest of the
+   page is stack, which needs no initialization. */
 static void
 init_thread(struct thread *t, const char *name, int priority)
 {
@@ -544,30 +1135,89 @@ init_thread(struct thread *t, const char *name, int priority)
 	t->stack = (uint8_t *)t + PGSIZE;
 	t->priority = priority;
   t->original_priority = priority;
-  list_init(&t->donated_priorities);
+  t->held_lock_cnt = 0;
   t->waiting_on_lock = NULL;
+  t->held_rwlock_cnt = 0;
+  t->waiting_on_rwlock = NULL;
+  t->wait_heap = NULL;
 	t->magic = THREAD_MAGIC;
 
 	sema_init(&t->sync_lock,0);
-	list_init(&t->children);
 
   t->nice = 0;
   t->recent_cpu.value = 0;
+  t->decayed_at = decay_passes;
+  t->ready_tsc = 0;
+  t->vruntime = min_vruntime;
 	old_level = intr_disable();
 	list_push_back(&all_list, &t->allelem);
 	intr_set_level(old_level);
 }
 
-struct thread* get_thread_by_tid(tid_t tid){
-	struct thread* current = thread_current();
-    struct list_elem *e;
-    
-    for (e = list_begin(&current->children); e != list_end(&current->children); e = list_next(e)) {
-        struct thread *child = list_entry(e, struct thread, child_elem);
-        if (child->tid == tid)
-            return child;
-    }
-    return NULL;
+/* Returns the exit record of the running thread's child TID, or
+   a null pointer if TID is not one of its children or has
+   already been removed from `children'. */
+struct child_record *
+thread_find_child(tid_t tid)
+{
+  struct child_record key;
+  struct hash_elem *e;
+
+  key.tid = tid;
+  e = hash_find(&thread_current()->children, &key.elem);
+  return e != NULL ? hash_entry(e, struct child_record, elem) : NULL;
+}
+
+/* Initializes H as a table of child_records keyed by tid, like
+   a thread's `children'. */
+bool child_record_table_init(struct hash *h)
+{
+  return hash_init(h, child_record_hash, child_record_less, NULL);
+}
+
+/* Drops the references to the child_records in H and destroys
+   it. */
+void child_record_table_destroy(struct hash *h)
+{
+  hash_destroy(h, child_record_destroy);
+}
+
+/* Drops a reference to R, held by either the parent or the
+   child, and frees R once both are done with it. */
+void child_record_release(struct child_record *r)
+{
+  enum intr_level old_level;
+  bool last;
+
+  old_level = intr_disable();
+  last = --r->ref_cnt == 0;
+  intr_set_level(old_level);
+  if (last)
+    kmem_cache_free(&record_cache, r);
+}
+
+/* Hashes a child_record by tid. */
+static unsigned
+child_record_hash(const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct child_record *r = hash_entry(e, struct child_record, elem);
+  return hash_int(r->tid);
+}
+
+/* Orders child_records by tid. */
+static bool
+child_record_less(const struct hash_elem *a, const struct hash_elem *b,
+                  void *aux UNUSED)
+{
+  return hash_entry(a, struct child_record, elem)->tid
+         < hash_entry(b, struct child_record, elem)->tid;
+}
+
+/* Drops the parent's reference to a child_record. */
+static void
+child_record_destroy(struct hash_elem *e, void *aux UNUSED)
+{
+  child_record_release(hash_entry(e, struct child_record, elem));
 }
 
 /* Allocates a SIZE-byte frame at the top of thread T's stack and
@@ -592,6 +1242,125 @@ bool priority_less(const struct list_elem *a,
   return get_prority_of_a_thread(thread_a) > get_prority_of_a_thread(thread_b);
 }
 
+/* Returns true if T is a real-time thread whose current job is
+   still within budget, and therefore runs ahead of all others. */
+static bool
+rt_active(const struct thread *t)
+{
+  return t->rt.period != 0 && t->rt.used < t->rt.budget;
+}
+
+/* Orders real-time threads so that the earliest deadline is the
+   greatest. */
+static bool
+deadline_less(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED)
+{
+  return heap_entry(a, struct thread, rt_elem)->rt.abs_deadline
+         > heap_entry(b, struct thread, rt_elem)->rt.abs_deadline;
+}
+
+/* Appends T to the ready queue for its current priority, or
+   under CFS inserts it in the run tree.  A real-time thread
+   within budget goes in the EDF queue instead. */
+static void
+ready_queue_push(struct thread *t)
+{
+  if (rt_active(t))
+    heap_insert(&rt_ready, &t->rt_elem);
+  else if (thread_cfs)
+    rb_insert(&cfs_tree, &t->run_node);
+  else
+  {
+    list_push_back(&ready_queues[t->priority], &t->elem);
+    ready_bitmap |= (uint64_t) 1 << t->priority;
+  }
+  ready_cnt++;
+}
+
+/* Removes T from whichever ready queue holds it. */
+static void
+ready_queue_remove(struct thread *t)
+{
+  if (rt_active(t))
+    heap_remove(&rt_ready, &t->rt_elem);
+  else if (thread_cfs)
+    rb_remove(&cfs_tree, &t->run_node);
+  else
+  {
+    list_remove(&t->elem);
+    if (list_empty(&ready_queues[t->priority]))
+      ready_bitmap &= ~((uint64_t) 1 << t->priority);
+  }
+  ready_cnt--;
+}
+
+/* Orders threads in a CFS run tree by vruntime. */
+static bool
+vruntime_less(const struct rb_elem *a, const struct rb_elem *b, void *aux UNUSED)
+{
+  return rb_entry(a, struct thread, run_node)->vruntime
+         < rb_entry(b, struct thread, run_node)->vruntime;
+}
+
+/* Returns the index of the most significant set bit in X, which
+   must be nonzero.  X is scanned as two 32-bit halves so that GCC
+   emits a plain `bsr' instead of a libgcc call. */
+static int
+bit_scan_reverse(uint64_t x)
+{
+  uint32_t high = x >> 32;
+  uint32_t low = x;
+
+  ASSERT(x != 0);
+  if (high != 0)
+    return 63 - __builtin_clz(high);
+  return 31 - __builtin_clz(low);
+}
+
+/* Returns the highest priority set in BITMAP, which must be
+   nonzero. */
+static int
+highest_ready_priority(uint64_t bitmap)
+{
+  return bit_scan_reverse(bitmap);
+}
+
+/* Removes and returns the real-time thread with the earliest
+   deadline, if any; otherwise the oldest thread in the
+   highest-priority non-empty ready queue, or under CFS the thread
+   with the least vruntime; or a null pointer if no thread is
+   ready. */
+static struct thread *
+ready_queue_pop(void)
+{
+  struct thread *t;
+
+  if (!heap_empty(&rt_ready))
+  {
+    t = heap_entry(heap_max(&rt_ready), struct thread, rt_elem);
+    ready_queue_remove(t);
+    return t;
+  }
+  if (thread_cfs)
+  {
+    struct rb_elem *e = rb_min(&cfs_tree);
+
+    if (e == NULL)
+      return NULL;
+    t = rb_entry(e, struct thread, run_node);
+    ready_queue_remove(t);
+    if (t->vruntime > min_vruntime)
+      min_vruntime = t->vruntime;
+    return t;
+  }
+  if (ready_bitmap == 0)
+    return NULL;
+  t = list_entry(list_front(&ready_queues[highest_ready_priority(ready_bitmap)]),
+                 struct thread, elem);
+  ready_queue_remove(t);
+  return t;
+}
+
 /* Chooses and returns the next thread to be scheduled.  Should
    return a thread from the run queue, unless the run queue is
    empty.  (If the running thread can continue running, then it
@@ -600,10 +1369,9 @@ bool priority_less(const struct list_elem *a,
 static struct thread *
 next_thread_to_run(void)
 {
-  if (list_empty(&ready_list))
-    return idle_thread;
-  else
-    return list_entry(list_pop_front(&ready_list), struct thread, elem);
+  struct thread *next = ready_queue_pop();
+
+  return next != NULL ? next : idle_thread;
 }
 /* Completes a thread switch by activating the new thread's page
    tables, and, if the previous thread is dying, destroying it.
@@ -629,9 +1397,12 @@ void thread_schedule_tail(struct thread *prev)
 
 	/* Mark us as running. */
 	cur->status = THREAD_RUNNING;
+  if (cur != idle_thread)
+    record_wakeup_latency(cur);
 
 	/* Start new time slice. */
 	thread_ticks = 0;
+  timer_tickless_update();
 
 #ifdef USERPROG
   /* Activate the new address space. */
@@ -646,10 +1417,42 @@ void thread_schedule_tail(struct thread *prev)
   if (prev != NULL && prev->status == THREAD_DYING && prev != initial_thread)
   {
     ASSERT(prev != cur);
-    palloc_free_page(prev);
+    thread_page_free(prev);
   }
 }
 
+/* Returns a page for a new thread, preferably one recycled from a
+   dead thread, or a null pointer if no memory is available.  The
+   page's contents are arbitrary. */
+static struct thread *
+thread_page_alloc(void)
+{
+  struct thread *t = NULL;
+  enum intr_level old_level;
+
+  old_level = intr_disable();
+  if (thread_cache_cnt > 0)
+    t = thread_cache[--thread_cache_cnt];
+  intr_set_level(old_level);
+
+  return t != NULL ? t : palloc_get_page(0);
+}
+
+/* Releases the page of dead thread T, keeping it in the cache if
+   there is room.  T's magic is cleared so that stale pointers to
+   it fail is_thread(). */
+static void
+thread_page_free(struct thread *t)
+{
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  t->magic = 0;
+  if (thread_cache_cnt < THREAD_CACHE_MAX)
+    thread_cache[thread_cache_cnt++] = t;
+  else
+    palloc_free_page(t);
+}
+
 /* Schedules a new process.  At entry, interrupts must be off and
    the running process's state must have been changed from
    running to some other state.  This function finds another
@@ -669,7 +1472,15 @@ schedule(void)
   ASSERT(is_thread(next));
 
   if (cur != next)
+  {
+    if (cur->status == THREAD_BLOCKED)
+      cur->usage.voluntary_switches++;
+    else if (cur->status == THREAD_READY)
+      cur->usage.involuntary_switches++;
+    trace_event(TRACE_SWITCH_OUT, cur, cur->status);
+    trace_event(TRACE_SWITCH_IN, next, 0);
     prev = switch_threads(cur, next);
+  }
   thread_schedule_tail(prev);
 }
 
@@ -687,49 +1498,69 @@ allocate_tid(void)
 	return tid;
 }
 
-void repair_file_table(struct thread* t){
-	struct list_elem *e;
-	int count = 0;
-	for (e = list_begin(&t->files); e != list_end(&t->files); e = list_next(e))
-		count++;
-	t->files_cnt = count;
-}
-
 /* Offset of `stack' member within `struct thread'.
    Used by switch.S, which can't figure it out on its own. */
 uint32_t thread_stack_ofs = offsetof(struct thread, stack);
 
-void calculatePriority(struct thread *t, void *aux UNUSED)
+/* Returns the priority the advanced scheduler assigns to T. */
+static int
+mlfqs_priority(struct thread *t)
 {
-  ASSERT(t->priority >= PRI_MIN && t->priority <= PRI_MAX);
   ASSERT(t->nice >= NICE_MIN && t->nice <= NICE_MAX);
   int p = PRI_MAX - int_floor(div_fixed_by_int(t->recent_cpu, 4)) - t->nice * 2;
   if (p < PRI_MIN)
     p = PRI_MIN;
   else if (p > PRI_MAX)
     p = PRI_MAX;
-  t->priority = p;
+  return p;
+}
+
+void calculatePriority(struct thread *t, void *aux UNUSED)
+{
+  ASSERT(t->priority >= PRI_MIN && t->priority <= PRI_MAX);
+  thread_change_priority(t, mlfqs_priority(t));
 }
 
 void calculateLoadAvg(void)
 {
-  int ready_threads = list_size(&ready_list);
+  int ready_threads = ready_cnt;
+  int i;
   if (thread_current() != idle_thread)
   {
     ready_threads++;
   }
+  for (i = 0; i < load_exempt_cnt; i++)
+    if (load_exempt[i]->status == THREAD_READY
+        || load_exempt[i]->status == THREAD_RUNNING)
+      ready_threads--;
   load_avg = add_two_fixed(mult_two_fixed(div_fixed_by_int(convert_to_fixed(59), 60), load_avg), mult_fixed_by_int(div_fixed_by_int(convert_to_fixed(1), 60), ready_threads));
 }
 
+/* Brings T's recent_cpu up to date with every decay pass made
+   since it was last decayed.  Passes older than the history are
+   not replayed; see DECAY_HISTORY. */
 void calculateRecentCpu(struct thread *t)
 {
-  ASSERT(t->priority >= PRI_MIN && t->priority <= PRI_MAX);
+  unsigned missed;
+  unsigned pass;
+
   ASSERT(t->nice >= NICE_MIN && t->nice <= NICE_MAX);
-  if (t != idle_thread)
+
+  missed = decay_passes - t->decayed_at;
+  t->decayed_at = decay_passes;
+  if (t == idle_thread || missed == 0)
+    return;
+
+  if (missed > DECAY_HISTORY)
   {
-    fixed_point recent_cpu = add_int_to_fixed(mult_two_fixed(div_two_fixed((mult_fixed_by_int(load_avg, 2)), (add_int_to_fixed(mult_fixed_by_int(load_avg, 2), 1))), t->recent_cpu), t->nice);
-    t->recent_cpu = recent_cpu;
+    missed = DECAY_HISTORY;
+    t->recent_cpu = convert_to_fixed(0);
   }
+  pass = decay_passes - missed + 1;
+  for (; pass != decay_passes + 1; pass++)
+    t->recent_cpu = add_int_to_fixed(mult_two_fixed(decay_history[pass % DECAY_HISTORY],
+                                                    t->recent_cpu),
+                                     t->nice);
 }
 
 void incrementRecentCpu(void)
@@ -740,8 +1571,62 @@ void incrementRecentCpu(void)
   }
 }
 
-void updateAllPriorities(void)
+/* Once-per-second pass of the advanced scheduler.  Records this
+   second's decay coefficient, then decays recent_cpu and
+   recomputes the priority of the running thread and of every
+   ready thread, moving each ready thread to the queue for its
+   new priority.  Blocked threads are left alone until
+   thread_unblock(), so the cost depends only on the number of
+   runnable threads.
+
+   Runs in the worker thread (see handle_mlfqs()), so interrupts
+   are turned off only while the ready queues are refiled. */
+void decayAllRecentCpu(void)
+{
+  struct thread *cur = thread_current();
+  fixed_point twice_load;
+  enum intr_level old_level;
+  struct list runnable;
+  int p;
+
+  old_level = intr_disable();
+  twice_load = mult_fixed_by_int(load_avg, 2);
+  decay_passes++;
+  decay_history[decay_passes % DECAY_HISTORY] =
+      div_two_fixed(twice_load, add_int_to_fixed(twice_load, 1));
+
+  if (cur != idle_thread)
+  {
+    calculateRecentCpu(cur);
+    calculatePriority(cur, NULL);
+  }
+
+  /* Empty the ready queues from the highest priority down, which
+     keeps threads in their current scheduling order, then refile
+     each thread under its new priority. */
+  list_init(&runnable);
+  for (p = PRI_MAX; p >= PRI_MIN; p--)
+    while (!list_empty(&ready_queues[p]))
+      list_push_back(&runnable, list_pop_front(&ready_queues[p]));
+  ready_bitmap = 0;
+  ready_cnt = heap_size(&rt_ready);
+
+  while (!list_empty(&runnable))
+  {
+    struct thread *t = list_entry(list_pop_front(&runnable), struct thread, elem);
+    calculateRecentCpu(t);
+    t->priority = mlfqs_priority(t);
+    ready_queue_push(t);
+  }
+  intr_set_level(old_level);
+}
+
+/* Recomputes the priority of the running thread, the only thread
+   whose recent_cpu changes between decay passes. */
+void updateCurrentPriority(void)
 {
-  thread_foreach(calculatePriority, NULL);
-  list_sort(&ready_list, priority_less, NULL);
-}
\ No newline at end of file
+  struct thread *cur = thread_current();
+
+  if (cur != idle_thread)
+    calculatePriority(cur, NULL);
+}
@@ -2,7 +2,10 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <hash.h>
 #include <list.h>
+#include <rbtree.h>
+#include <rusage.h>
 #include <stdint.h>
 #include "synch.h"
 #include "threads/fixedPoint.h"
@@ -24,6 +27,8 @@ typedef int tid_t;
 #define PRI_MIN 0      /* Lowest priority. */
 #define PRI_DEFAULT 31 /* Default priority. */
 #define PRI_MAX 63     /* Highest priority. */
+#define MAX_HELD_LOCKS 16 /* Max locks a thread may hold at once. */
+#define MAX_HELD_RWLOCKS 4 /* Max reader-writer locks held at once. */
 #define MAX_FILES_PER_PROCESS 128
 #define SYSTEM_FILES 3
 #define PRI_MIN 0      /* Lowest priority. */
@@ -80,11 +85,55 @@ typedef int tid_t;
    set to THREAD_MAGIC.  Stack overflow will normally change this
    value, triggering the assertion. */
 /* The `elem' member has a dual purpose.  It can be an element in
-   the run queue (thread.c), or it can be an element in a
-   semaphore wait list (synch.c).  It can be used these two ways
-   only because they are mutually exclusive: only a thread in the
-   ready state is on the run queue, whereas only a thread in the
-   blocked state is on a semaphore wait list. */
+   the run queue (thread.c), or it can be an element in a slot of
+   the sleep wheel (thread.c).  It can be used these two ways only
+   because they are mutually exclusive: only a thread in the ready
+   state is on the run queue, whereas only a thread in the blocked
+   state is in the sleep wheel.
+
+   A thread blocked in sema_down() sits in the semaphore's waiter
+   heap through `wait_elem' instead.  That heap is ordered by the
+   waiter's priority, so `wait_heap' and `wait_heap_elem' record
+   the priority-ordered wait queue the thread is in, if any, and
+   thread_change_priority() re-keys it there when a donation
+   changes the thread's priority.  For a thread in cond_wait()
+   that is the condition's queue rather than the private
+   semaphore it blocks on. */
+
+/* Exit status of a child thread.  It is shared by the parent,
+   which finds it by tid in its `children' hash, and the child, so
+   that it outlives whichever of the two exits first.  Kernel
+   threads started by kernel threads cannot be waited for and
+   have none. */
+struct child_record
+{
+   tid_t tid;               /* Child's thread identifier. */
+   int exit_status;         /* Valid once `exited' has been upped. */
+   struct semaphore exited; /* Upped when the child exits. */
+   int ref_cnt;             /* # of parent and child still using it. */
+   struct hash_elem elem;   /* Element in the parent's `children'. */
+};
+
+/* Reservation of a thread in the real-time class, which runs in
+   earliest-deadline-first order ahead of all other threads.  A
+   thread releases one job per period; each job may use up to
+   `budget' ticks of CPU time and should finish within `deadline'
+   ticks of its release.  All times are in timer ticks.  A thread
+   is real-time while `period' is nonzero. */
+struct rt_params
+{
+   int64_t period;       /* Time between releases, or 0. */
+   int64_t budget;       /* CPU time allowed per job. */
+   int64_t deadline;     /* Deadline relative to each release. */
+   int density;          /* Reserved share, budget / deadline. */
+   int64_t release;      /* Release time of the current job. */
+   int64_t abs_deadline; /* Deadline of the current job. */
+   int64_t used;         /* CPU time used by the current job. */
+   unsigned jobs;        /* # of jobs released so far. */
+   unsigned misses;      /* # of those that missed their deadline. */
+};
+
+struct process;
 
 struct open_file
 {
@@ -92,6 +141,7 @@ struct open_file
    const char *name;
    struct list_elem elem;
    int fd;
+   int ref_cnt;    /* Fd table's reference plus one per user. */
 };
 struct thread
 
@@ -103,39 +153,49 @@ struct thread
    uint8_t *stack;            /* Saved stack pointer. */
    int priority;              /* Priority. */
    struct list_elem allelem;  /* List element for all threads list. */
-   int original_priority;
-   struct list donated_priorities; /* List of locks held by the thread. */
-   struct lock *waiting_on_lock;
+   int original_priority;     /* Priority before donation. */
+   struct lock *held_locks[MAX_HELD_LOCKS]; /* Max-heap of held locks,
+                                               keyed by max_waiter_priority. */
+   int held_lock_cnt;         /* # of locks in held_locks. */
+   struct lock *waiting_on_lock; /* Lock this thread is blocked on. */
+   struct rwlock *held_rwlocks[MAX_HELD_RWLOCKS]; /* Reader-writer locks
+                                                     held in either mode. */
+   int held_rwlock_cnt;       /* # of locks in held_rwlocks. */
+   struct rwlock *waiting_on_rwlock; /* Reader-writer lock we wait for. */
 
    int nice;               /* Niceness value. */
    fixed_point recent_cpu; /* Recent CPU usage for advanced scheduler. */
+   unsigned decayed_at;    /* Decay passes applied to recent_cpu. */
+   uint64_t ready_tsc;     /* TSC when last unblocked, or 0. */
+   uint64_t vruntime;      /* Weighted run time under CFS. */
+   struct rb_elem run_node; /* Element in the CFS run tree. */
+   struct rt_params rt;    /* Real-time reservation, if any. */
+   struct heap_elem rt_elem; /* Element in the EDF run queue. */
+   struct rusage usage;    /* CPU time and other resources used. */
 
    /* Shared between thread.c and synch.c. */
    struct list_elem elem; /* List element. */
+   int64_t wake_tick;     /* Tick to wake at while in the sleep wheel. */
+   struct heap_elem wait_elem;       /* Element in a semaphore's waiters. */
+   struct heap *wait_heap;           /* Wait queue ordered by our priority. */
+   struct heap_elem *wait_heap_elem; /* Our element in wait_heap. */
 
    /* Owned by userprog/process.c. */
    uint32_t *pagedir; /* Page directory. */
    /* Huthaifa for userprog*/
    struct thread *parent;
-   struct list children;
-   struct list_elem child_elem;
+   struct hash children;        /* Our children's child_records. */
+   struct child_record *record; /* Our record in parent's `children',
+                                   or null. */
    int exit_status;
    int child_exit_status;
    struct file *executable;
 
    struct semaphore sync_lock;
-   tid_t wait_on;
 
-   /* files the process ownes */
-   int files_cnt;
-   struct list files;
-   int next_fd;
-   /* Owned by thread.c. */
-   unsigned magic; /* Detects stack overflow. */
-#ifdef USERPROG
-   /* Owned by userprog/process.c. */
-   uint32_t *pagedir; /* Page directory. */
-#endif
+   struct process *process; /* Process we belong to, shared with its
+                               other threads, or null. */
+   int stack_slot;          /* Our user stack within the process. */
 
    /* Owned by thread.c. */
    unsigned magic; /* Detects stack overflow. */
@@ -146,29 +206,32 @@ struct thread
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
-static struct list sleep_list;
-
-struct sleeping_thread
-{
-   struct list_elem elem; /* List element. */
-   struct thread *thread;
-   int64_t wake_tick;
-};
+/* If true, use the completely fair scheduler instead.
+   Controlled by kernel command-line option "-o cfs". */
+extern bool thread_cfs;
 
 void thread_init(void);
 void thread_start(void);
 
 void thread_sleep(int64_t wake_tick);
 void thread_wake_sleeping_threads(int64_t current_tick);
+int64_t thread_next_wake_tick(void);
+int thread_ticks_to_preempt(void);
 
-void thread_tick(void);
+void thread_tick(bool user);
 void thread_print_stats(void);
 
 typedef void thread_func(void *aux);
 tid_t thread_create(const char *name, int priority, thread_func *, void *, struct file *);
 
+struct child_record *thread_find_child(tid_t);
+void child_record_release(struct child_record *);
+bool child_record_table_init(struct hash *);
+void child_record_table_destroy(struct hash *);
+
 void thread_block(void);
 void thread_unblock(struct thread *);
+bool thread_preempts(const struct thread *, const struct thread *cur);
 
 struct thread *thread_current(void);
 tid_t thread_tid(void);
@@ -176,6 +239,7 @@ const char *thread_name(void);
 
 void thread_exit(void) NO_RETURN;
 void thread_yield(void);
+void thread_yield_if_outranked(void);
 
 /* Performs some operation on thread t, given auxiliary data AUX. */
 typedef void thread_action_func(struct thread *t, void *aux);
@@ -184,18 +248,25 @@ void thread_foreach(thread_action_func *, void *);
 int thread_get_priority(void);
 void thread_set_priority(int);
 int get_prority_of_a_thread(struct thread *);
+void thread_change_priority(struct thread *, int priority);
 
 int thread_get_nice(void);
 void thread_set_nice(int);
 int thread_get_recent_cpu(void);
 int thread_get_load_avg(void);
+void thread_exclude_from_load(void);
+
+bool thread_set_realtime(int64_t period, int64_t budget, int64_t deadline);
+void thread_clear_realtime(void);
+void thread_wait_next_period(void);
+void thread_get_rt_stats(unsigned *jobs, unsigned *misses);
 
 void calculatePriority(struct thread *t, void *aux UNUSED);
 void calculateLoadAvg(void);
 void calculateRecentCpu(struct thread *t);
 void incrementRecentCpu(void);
-void updateAllPriorities(void);
+void decayAllRecentCpu(void);
+void updateCurrentPriority(void);
 bool priority_less(const struct list_elem *a, const struct list_elem *b, void *aux);
-void repair_file_table(struct thread *);
 
 #endif /* threads/thread.h */
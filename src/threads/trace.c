@@ -0,0 +1,111 @@
+#include "threads/trace.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/serial.h"
+#include "devices/timer.h"
+#include "threads/thread.h"
+#include "threads/tsc.h"
+
+/* Number of events in the ring buffer.  Must be a power of 2. */
+#define TRACE_SIZE 4096
+
+/* Dump format version, bumped whenever struct trace_event or
+   struct trace_header changes. */
+#define TRACE_VERSION 1
+
+/* Header that precedes the events in a dump.  The events follow
+   oldest first.  Duplicated in utils/pintos-trace.c. */
+struct trace_header
+  {
+    char magic[8];              /* "PINTRACE". */
+    uint32_t version;           /* TRACE_VERSION. */
+    uint32_t event_size;        /* sizeof (struct trace_event). */
+    uint32_t event_cnt;         /* # of events that follow. */
+    uint32_t recorded;          /* # of events ever recorded. */
+    uint32_t timer_freq;        /* Timer ticks per second. */
+  };
+
+/* If false (default), trace_event() does nothing.
+   If true, scheduler events are recorded and dumped at power-off.
+   Controlled by kernel command-line option "-trace". */
+bool trace_enabled;
+
+/* Ring buffer.  Each recorder claims the next slot with an
+   atomic increment of trace_head and then fills it in, so
+   recorders never wait for one another, even across CPUs or when
+   an interrupt handler records in the middle of another record.
+   Event N lives at trace_ring[N % TRACE_SIZE]. */
+static struct trace_event trace_ring[TRACE_SIZE];
+static volatile uint32_t trace_head;   /* # of slots claimed. */
+
+static void dump_bytes (const void *, size_t);
+
+/* Atomically increments *P and returns its old value. */
+static inline uint32_t
+fetch_and_increment (volatile uint32_t *p)
+{
+  uint32_t old = 1;
+  asm volatile ("lock xaddl %0, %1" : "+r" (old), "+m" (*p) : : "memory");
+  return old;
+}
+
+/* Records an event of TYPE about thread T with argument ARG.
+   Use trace_event() instead, which skips this call when tracing
+   is disabled. */
+void
+trace_record (enum trace_type type, struct thread *t, int32_t arg)
+{
+  struct trace_event *e;
+
+  e = &trace_ring[fetch_and_increment (&trace_head) & (TRACE_SIZE - 1)];
+  e->tsc = rdtsc ();
+  e->tick = timer_ticks ();
+  e->tid = t->tid;
+  e->arg = arg;
+  e->type = type;
+  e->priority = t->priority;
+  e->pad = 0;
+}
+
+/* Writes the trace buffer to the serial port in binary, if
+   tracing is enabled, and stops tracing. */
+void
+trace_dump (void)
+{
+  struct trace_header h;
+  uint32_t head, first, i;
+
+  if (!trace_enabled)
+    return;
+  trace_enabled = false;
+
+  head = trace_head;
+  first = head > TRACE_SIZE ? head - TRACE_SIZE : 0;
+
+  memcpy (h.magic, "PINTRACE", sizeof h.magic);
+  h.version = TRACE_VERSION;
+  h.event_size = sizeof (struct trace_event);
+  h.event_cnt = head - first;
+  h.recorded = head;
+  h.timer_freq = TIMER_FREQ;
+
+  printf ("Trace: dumping %"PRIu32" of %"PRIu32" scheduler events.\n",
+          h.event_cnt, h.recorded);
+  dump_bytes (&h, sizeof h);
+  for (i = first; i != head; i++)
+    dump_bytes (&trace_ring[i & (TRACE_SIZE - 1)], sizeof (struct trace_event));
+  serial_flush ();
+}
+
+/* Sends the SIZE bytes at BUF to the serial port, bypassing the
+   console so that they do not show up on the VGA display. */
+static void
+dump_bytes (const void *buf_, size_t size)
+{
+  const uint8_t *buf = buf_;
+
+  while (size-- > 0)
+    serial_putc (*buf++);
+}
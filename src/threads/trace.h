@@ -0,0 +1,60 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct thread;
+
+/* Scheduler event trace.
+
+   When enabled with the "-trace" kernel option, the scheduler
+   records its events into a fixed-size ring buffer, overwriting
+   the oldest events once it is full.  At power-off the buffer is
+   written in binary to the serial port, where utils/pintos-trace
+   can find it and print it as a timeline. */
+
+/* Kinds of trace events. */
+enum trace_type
+  {
+    TRACE_SWITCH_OUT,           /* Thread stops running; ARG is its
+                                   new thread_status. */
+    TRACE_SWITCH_IN,            /* Thread starts running. */
+    TRACE_BLOCK,                /* Thread blocks. */
+    TRACE_UNBLOCK,              /* Thread becomes ready. */
+    TRACE_DONATE,               /* Thread receives a donation;
+                                   ARG is the donor's tid. */
+    TRACE_SLEEP,                /* Thread sleeps; ARG is the wake
+                                   tick. */
+    TRACE_WAKE                  /* Sleeping thread is woken. */
+  };
+
+/* One trace event.  The layout is part of the dump format and
+   is duplicated in utils/pintos-trace.c. */
+struct trace_event
+  {
+    uint64_t tsc;               /* Time-stamp counter. */
+    uint32_t tick;              /* Timer tick. */
+    int32_t tid;                /* Thread the event is about. */
+    int32_t arg;                /* Event-specific argument. */
+    uint8_t type;               /* A trace_type. */
+    uint8_t priority;           /* Thread's priority at the time. */
+    uint16_t pad;               /* Unused. */
+  };
+
+extern bool trace_enabled;
+
+void trace_record (enum trace_type, struct thread *, int32_t arg);
+void trace_dump (void);
+
+/* Records an event of TYPE about thread T with argument ARG, if
+   tracing is enabled.  Cheap enough to leave in the scheduler's
+   hot paths. */
+static inline void
+trace_event (enum trace_type type, struct thread *t, int32_t arg)
+{
+  if (trace_enabled)
+    trace_record (type, t, arg);
+}
+
+#endif /* threads/trace.h */
@@ -0,0 +1,122 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include "threads/interrupt.h"
+#include "threads/spinlock.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Queued work items, oldest first.  Protected by queue_lock with
+   interrupts off, since interrupt handlers on any CPU add to it. */
+static struct list queue = LIST_INITIALIZER (queue);
+static struct spinlock queue_lock;
+
+/* Upped once for each item added to the queue.  The worker downs
+   it once for each item it takes off. */
+static struct semaphore queue_items;
+
+/* The worker thread, or NULL before workqueue_start(). */
+static struct thread *worker;
+
+static thread_func worker_thread;
+
+/* Initializes W to run FUNC when queued. */
+void
+work_init (struct work *w, work_func *func)
+{
+  ASSERT (w != NULL);
+  ASSERT (func != NULL);
+
+  w->func = func;
+  w->pending = false;
+}
+
+/* Queues W to be run by the worker thread.  If W is already
+   queued and has not yet started, does nothing and returns false,
+   so an item queued several times before it runs runs once;
+   otherwise returns true.  W may be queued again from its own
+   function.
+
+   May be called from an interrupt handler.  In that case the
+   worker runs as soon as the handler returns.  Items queued
+   before workqueue_start() run once the worker starts. */
+bool
+work_queue (struct work *w)
+{
+  enum intr_level old_level;
+
+  ASSERT (w != NULL && w->func != NULL);
+
+  old_level = intr_disable ();
+  spinlock_acquire (&queue_lock);
+  if (w->pending)
+    {
+      spinlock_release (&queue_lock);
+      intr_set_level (old_level);
+      return false;
+    }
+  w->pending = true;
+  list_push_back (&queue, &w->elem);
+  spinlock_release (&queue_lock);
+
+  sema_up (&queue_items);
+  if (intr_context () && worker != NULL)
+    intr_yield_on_return ();
+  intr_set_level (old_level);
+  return true;
+}
+
+/* Initializes the work queue.  Must be called before interrupts
+   are first enabled, since an interrupt handler may queue work. */
+void
+workqueue_init (void)
+{
+  spinlock_init (&queue_lock);
+  sema_init (&queue_items, 0);
+}
+
+/* Starts the worker thread.  Must be called after
+   thread_start(). */
+void
+workqueue_start (void)
+{
+  struct semaphore started;
+
+  sema_init (&started, 0);
+  thread_create ("worker", PRI_MAX, worker_thread, &started, NULL);
+  sema_down (&started);
+}
+
+/* Worker thread.  Runs queued work items, one at a time in the
+   order they were queued, with interrupts on. */
+static void
+worker_thread (void *started_)
+{
+  struct semaphore *started = started_;
+
+  /* The advanced schedulers ignore the priority we were created
+     with, so ask for the largest share they give out instead. */
+  if (thread_mlfqs || thread_cfs)
+    thread_set_nice (-20);
+  thread_exclude_from_load ();
+  worker = thread_current ();
+  sema_up (started);
+
+  for (;;)
+    {
+      enum intr_level old_level;
+      struct work *w;
+
+      sema_down (&queue_items);
+
+      old_level = intr_disable ();
+      spinlock_acquire (&queue_lock);
+      ASSERT (!list_empty (&queue));
+      w = list_entry (list_pop_front (&queue), struct work, elem);
+      w->pending = false;
+      spinlock_release (&queue_lock);
+      intr_set_level (old_level);
+
+      ASSERT (intr_get_level () == INTR_ON);
+      w->func (w);
+    }
+}
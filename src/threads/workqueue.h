@@ -0,0 +1,37 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+
+/* Deferred work.
+
+   An interrupt handler that has more to do than it should do
+   with interrupts off queues a work item instead.  A kernel
+   thread at PRI_MAX, the worker, runs queued items in order with
+   interrupts on.  An item queued from an interrupt handler runs
+   as soon as the handler returns, ahead of the interrupted
+   thread, so the delay is one context switch. */
+
+struct work;
+
+/* Function run for a work item W. */
+typedef void work_func (struct work *w);
+
+/* A work item.  Typically embedded in the structure it works on,
+   which WORK_FUNC then finds with list_entry()-style arithmetic,
+   or simply static. */
+struct work
+  {
+    struct list_elem elem;      /* Element in the work queue. */
+    work_func *func;            /* Function to run. */
+    bool pending;               /* Queued but not yet started. */
+  };
+
+void work_init (struct work *, work_func *);
+bool work_queue (struct work *);
+
+void workqueue_init (void);
+void workqueue_start (void);
+
+#endif /* threads/workqueue.h */
@@ -0,0 +1,281 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <heap.h>
+#include <list.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
+#include "threads/kmem.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+
+/* Number of buckets.  Must be a power of 2. */
+#define FUTEX_BUCKETS 64
+
+/* A bucket.  Holds the wait queue of every futex word whose key
+   hashes to it, so a bucket may hold threads waiting on several
+   different words. */
+struct futex_bucket
+  {
+    struct lock lock;           /* Protects the rest. */
+    struct list queues;         /* struct futex_queue, one per word. */
+    struct list waiters;        /* Every struct futex_waiter, for
+                                   futex_wake_process(). */
+  };
+
+/* The wait queue of one futex word.  Exists only while some
+   thread is waiting on the word. */
+struct futex_queue
+  {
+    uintptr_t key;              /* Physical address of the word. */
+    struct heap waiters;        /* struct futex_waiter, highest
+                                   priority first. */
+    struct list_elem elem;      /* Element in a bucket's `queues'. */
+  };
+
+/* A thread waiting in futex_wait().  Lives on its stack. */
+struct futex_waiter
+  {
+    struct thread *thread;      /* Waiting thread. */
+    struct futex_queue *queue;  /* Queue we are in. */
+    struct semaphore wakeup;    /* Upped by futex_wake(). */
+    struct heap_elem heap_elem; /* Element in the queue's `waiters'. */
+    struct list_elem elem;      /* Element in a bucket's `waiters'. */
+  };
+
+static struct futex_bucket buckets[FUTEX_BUCKETS];
+
+/* Cache of struct futex_queue. */
+static struct kmem_cache queue_cache =
+    KMEM_CACHE_INITIALIZER ("futex_queue", sizeof (struct futex_queue),
+                            __alignof__ (struct futex_queue), NULL);
+
+static uintptr_t futex_key (int *uaddr, int **kaddr);
+static struct futex_bucket *futex_bucket (uintptr_t key);
+static struct futex_queue *futex_queue (struct futex_bucket *,
+                                        uintptr_t key);
+static void futex_dequeue (struct futex_bucket *, struct futex_waiter *);
+static heap_less_func futex_waiter_less;
+
+/* Initializes the futex wait queues. */
+void
+futex_init (void)
+{
+  int i;
+
+  for (i = 0; i < FUTEX_BUCKETS; i++)
+    {
+      lock_init (&buckets[i].lock);
+      list_init (&buckets[i].queues);
+      list_init (&buckets[i].waiters);
+    }
+}
+
+/* If the int at user address UADDR holds EXPECTED, blocks until
+   futex_wake() is called on the same word and returns true.
+   Otherwise returns false at once, because the word has already
+   changed since the caller read it, or because the caller's
+   process is exiting.  May also return false at once if the
+   kernel is out of memory, which the caller cannot tell from a
+   changed word; either way it must read the word again.
+
+   The check and the wait are atomic with respect to
+   futex_wake(), so a wake-up that follows the change that the
+   caller is waiting for is never lost.  UADDR must be a mapped,
+   aligned user address. */
+bool
+futex_wait (int *uaddr, int expected)
+{
+  struct futex_waiter w;
+  struct futex_bucket *b;
+  enum intr_level old_level;
+  uintptr_t key;
+  int *kaddr;
+
+  key = futex_key (uaddr, &kaddr);
+  w.thread = thread_current ();
+  sema_init (&w.wakeup, 0);
+
+  b = futex_bucket (key);
+  lock_acquire (&b->lock);
+  if (*(volatile int *) kaddr != expected || w.thread->process->exiting)
+    {
+      lock_release (&b->lock);
+      return false;
+    }
+  w.queue = futex_queue (b, key);
+  if (w.queue == NULL)
+    {
+      lock_release (&b->lock);
+      return false;
+    }
+  list_push_back (&b->waiters, &w.elem);
+
+  /* A donation to us while we wait must re-key our place in the
+     queue, as in cond_wait(). */
+  old_level = intr_disable ();
+  heap_insert (&w.queue->waiters, &w.heap_elem);
+  w.thread->wait_heap = &w.queue->waiters;
+  w.thread->wait_heap_elem = &w.heap_elem;
+  intr_set_level (old_level);
+  lock_release (&b->lock);
+
+  sema_down (&w.wakeup);
+  return true;
+}
+
+/* Wakes up to N threads waiting in futex_wait() on the int at
+   user address UADDR, highest priority first, and returns the
+   number woken.  UADDR must be a mapped, aligned user address. */
+int
+futex_wake (int *uaddr, int n)
+{
+  struct futex_bucket *b;
+  struct list_elem *e;
+  uintptr_t key;
+  int *kaddr;
+  int woken = 0;
+
+  key = futex_key (uaddr, &kaddr);
+  b = futex_bucket (key);
+  lock_acquire (&b->lock);
+  for (e = list_begin (&b->queues); e != list_end (&b->queues);
+       e = list_next (e))
+    {
+      struct futex_queue *q = list_entry (e, struct futex_queue, elem);
+      if (q->key != key)
+        continue;
+
+      /* Waking the last waiter frees Q, so check for that
+         first. */
+      while (woken < n)
+        {
+          struct futex_waiter *w;
+          bool last = heap_size (&q->waiters) == 1;
+
+          w = heap_entry (heap_max (&q->waiters), struct futex_waiter,
+                          heap_elem);
+          futex_dequeue (b, w);
+          woken++;
+          if (last)
+            break;
+        }
+      break;
+    }
+  lock_release (&b->lock);
+  return woken;
+}
+
+/* Wakes every thread of process P that is waiting in
+   futex_wait(), whatever word it is waiting on.  Called once P is
+   exiting, after which none of its threads starts a new wait. */
+void
+futex_wake_process (struct process *p)
+{
+  int i;
+
+  for (i = 0; i < FUTEX_BUCKETS; i++)
+    {
+      struct futex_bucket *b = &buckets[i];
+      struct list_elem *e, *next;
+
+      lock_acquire (&b->lock);
+      for (e = list_begin (&b->waiters); e != list_end (&b->waiters);
+           e = next)
+        {
+          struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+          next = list_next (e);
+          if (w->thread->process == p)
+            futex_dequeue (b, w);
+        }
+      lock_release (&b->lock);
+    }
+}
+
+/* Returns the wait queue for KEY in bucket B, creating it if
+   there is none, or a null pointer if out of memory.  B's lock
+   must be held. */
+static struct futex_queue *
+futex_queue (struct futex_bucket *b, uintptr_t key)
+{
+  struct futex_queue *q;
+  struct list_elem *e;
+
+  for (e = list_begin (&b->queues); e != list_end (&b->queues);
+       e = list_next (e))
+    {
+      q = list_entry (e, struct futex_queue, elem);
+      if (q->key == key)
+        return q;
+    }
+
+  q = kmem_cache_alloc (&queue_cache);
+  if (q == NULL)
+    return NULL;
+  q->key = key;
+  heap_init (&q->waiters, futex_waiter_less, NULL);
+  list_push_back (&b->queues, &q->elem);
+  return q;
+}
+
+/* Takes W out of its queue and bucket B and wakes it, freeing
+   the queue if W was its last waiter.  B's lock must be held. */
+static void
+futex_dequeue (struct futex_bucket *b, struct futex_waiter *w)
+{
+  struct futex_queue *q = w->queue;
+  enum intr_level old_level;
+  bool empty;
+
+  ASSERT (lock_held_by_current_thread (&b->lock));
+
+  list_remove (&w->elem);
+  old_level = intr_disable ();
+  heap_remove (&q->waiters, &w->heap_elem);
+  if (w->thread->wait_heap == &q->waiters)
+    w->thread->wait_heap = NULL;
+  empty = heap_empty (&q->waiters);
+  sema_up (&w->wakeup);
+  intr_set_level (old_level);
+
+  if (empty)
+    {
+      list_remove (&q->elem);
+      kmem_cache_free (&queue_cache, q);
+    }
+}
+
+/* Orders futex waiters by priority, so that the highest-priority
+   waiter is the greatest. */
+static bool
+futex_waiter_less (const struct heap_elem *a, const struct heap_elem *b,
+                   void *aux UNUSED)
+{
+  return heap_entry (a, struct futex_waiter, heap_elem)->thread->priority
+         < heap_entry (b, struct futex_waiter, heap_elem)->thread->priority;
+}
+
+/* Returns the key for the int at user address UADDR, its
+   physical address, and stores its kernel virtual address in
+   *KADDR.  Keying by physical address makes every mapping of the
+   same word meet in the same wait queue. */
+static uintptr_t
+futex_key (int *uaddr, int **kaddr)
+{
+  ASSERT (is_user_vaddr (uaddr));
+  ASSERT ((uintptr_t) uaddr % sizeof *uaddr == 0);
+
+  *kaddr = pagedir_get_page (thread_current ()->pagedir, uaddr);
+  ASSERT (*kaddr != NULL);
+  return vtop (*kaddr);
+}
+
+/* Returns the wait queue for KEY. */
+static struct futex_bucket *
+futex_bucket (uintptr_t key)
+{
+  return &buckets[hash_int (key / sizeof (int)) & (FUTEX_BUCKETS - 1)];
+}
@@ -0,0 +1,20 @@
+#ifndef USERPROG_FUTEX_H
+#define USERPROG_FUTEX_H
+
+#include <stdbool.h>
+
+struct process;
+
+/* Fast user-space mutexes.
+
+   User programs build their own locks on an int in their memory,
+   changing it with atomic instructions and entering the kernel
+   only to wait for, or wake up, threads contending for it.  The
+   kernel keeps no state for a word that no thread is waiting on. */
+
+void futex_init (void);
+bool futex_wait (int *uaddr, int expected);
+int futex_wake (int *uaddr, int n);
+void futex_wake_process (struct process *);
+
+#endif /* userprog/futex.h */
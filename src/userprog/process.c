@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "userprog/futex.h"
 #include "userprog/gdt.h"
 #include "userprog/pagedir.h"
 #include "userprog/tss.h"
@@ -14,6 +15,8 @@
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/kmem.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
@@ -23,7 +26,29 @@
 static void push_stack(int order, void **esp, char *token, char **argv, int argc);
 
 static thread_func start_process NO_RETURN;
+static thread_func start_thread NO_RETURN;
+static bool process_create(void);
 static bool load(const char *cmdline, void (**eip)(void), void **esp, char **save_ptr);
+static bool alloc_user_stack(struct thread *t);
+static void rusage_add(struct rusage *, const struct rusage *);
+static void free_user_stack(struct thread *t);
+static void release_executable(struct thread *t);
+
+/* Distance between the tops of the user stacks of a process's
+   threads.  Only the top page of each is mapped, so the pages in
+   between catch most stack overflows. */
+#define USER_STACK_STRIDE (16 * PGSIZE)
+
+/* Information passed from process_thread_create() to the new
+   thread it starts. */
+struct thread_start
+{
+	struct process *process;   /* Process to join. */
+	void (*entry)(void);	   /* User code to start running at. */
+	void *fn, *aux;			   /* Arguments to pass to ENTRY. */
+	struct semaphore started;  /* Upped once the thread is set up. */
+	bool success;			   /* Whether it could be set up. */
+};
 
 /* Starts a new thread running a user program loaded from
    FILENAME.  The new thread may be scheduled (and may even exit)
@@ -68,10 +93,17 @@ tid_t process_execute(const char *file_name)
 		palloc_free_page(fn_copy);
 	else
 	{
-		// struct thread* child = get_thread_by_tid(tid);
 		sema_down(&thread_current()->sync_lock);
 		if (thread_current()->child_exit_status == -1)
 		{
+			/* Our caller never learns the tid, so nobody will wait
+			   for the child: drop its exit record now. */
+			struct child_record *child = thread_find_child(tid);
+			if (child != NULL)
+			{
+				hash_delete(&thread_current()->children, &child->elem);
+				child_record_release(child);
+			}
 			tid = TID_ERROR;
 		}
 	}
@@ -96,7 +128,7 @@ start_process(void *file_name_)
 	if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
 	if_.cs = SEL_UCSEG;
 	if_.eflags = FLAG_IF | FLAG_MBS;
-	success = load(file_name, &if_.eip, &if_.esp, &save_ptr);
+	success = process_create() && load(file_name, &if_.eip, &if_.esp, &save_ptr);
 
 	struct thread *current_thread = thread_current();
 	struct thread *parent = current_thread->parent;
@@ -105,14 +137,15 @@ start_process(void *file_name_)
 	palloc_free_page(file_name);
 	if (!success)
 	{
+		parent->child_exit_status = -1;
+		current_thread->exit_status = -1;
 		sema_up(&parent->sync_lock);
-		current_thread->parent->child_exit_status = -1;
 		thread_exit();
 	}
 	else
 	{
+		parent->child_exit_status = 0;
 		sema_up(&parent->sync_lock);
-		sema_down(&current_thread->sync_lock);
 	}
 
 	/* Start the user process by simulating a return from an
@@ -125,6 +158,41 @@ start_process(void *file_name_)
 	NOT_REACHED();
 }
 
+/* Creates the process for the running thread, which becomes its
+   first thread and uses the stack that setup_stack() builds.
+   Returns true if successful, false on memory allocation
+   failure. */
+static bool
+process_create(void)
+{
+	struct thread *t = thread_current();
+	struct process *p = malloc(sizeof *p);
+
+	if (p == NULL)
+		return false;
+	if (!child_record_table_init(&p->threads))
+	{
+		free(p);
+		return false;
+	}
+	lock_init(&p->lock);
+	p->pagedir = NULL;
+	p->main_tid = t->tid;
+	p->thread_cnt = 1;
+	cond_init(&p->others_done);
+	p->stack_slots = 1;
+	p->exiting = false;
+	p->exit_status = 0;
+	memset(&p->exited_usage, 0, sizeof p->exited_usage);
+	p->files_cnt = SYSTEM_FILES;
+	list_init(&p->files);
+	p->next_fd = SYSTEM_FILES;
+
+	t->process = p;
+	t->stack_slot = 0;
+	return true;
+}
+
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
@@ -132,76 +200,353 @@ start_process(void *file_name_)
    been successfully called for the given TID, returns -1
    immediately, without waiting.
 
-   This function will be implemented in problem 2-2.  For now, it
-   does nothing. */
+   The child's exit record outlives the child, so this is a hash
+   lookup plus, if the child is still running, one semaphore
+   wait. */
 int process_wait(tid_t child_tid)
 {
-	struct thread *current_thread = thread_current();
-	struct thread *child = get_thread_by_tid(child_tid);
+	struct child_record *child = thread_find_child(child_tid);
+	int status;
 
 	if (child == NULL)
 		return -1;
 
-	current_thread->wait_on = child_tid;
+	/* A child can only be waited for once. */
+	hash_delete(&thread_current()->children, &child->elem);
 
-	sema_up(&child->sync_lock);
-	sema_down(&current_thread->sync_lock);
+	sema_down(&child->exited);
+	status = child->exit_status;
+	child_record_release(child);
+	return status;
+}
 
-	return current_thread->child_exit_status;
+/* The thread that loaded the program keeps its executable open,
+   and unwritable, until the process is gone.  Lets T's
+   executable, if any, be written again and closes it. */
+static void
+release_executable(struct thread *t)
+{
+	if (t->executable != NULL)
+	{
+		file_allow_write(t->executable);
+		file_close(t->executable);
+		t->executable = NULL;
+	}
 }
 
-/* Free the current process's resources. */
+/* Frees the current thread's share of its process's resources,
+   and the process itself if this is its last thread. */
 void process_exit(void)
 {
 	struct thread *cur = thread_current();
-	uint32_t *pd;
+	struct process *p = cur->process;
+	enum intr_level old_level;
+	bool last;
 
-	// Close all files using list iteration
-	struct list_elem *e;
-	while (!list_empty(&cur->files))
+	if (p == NULL)
 	{
-		e = list_begin(&cur->files);
+		release_executable(cur);
+		return;
+	}
+	free_user_stack(cur);
+
+	/* Correct ordering here is crucial.  We must set cur->pagedir
+	   to NULL before switching page directories, so that a timer
+	   interrupt can't switch back to the process page directory.
+	   We must activate the base page directory before the last
+	   thread destroys the process's page directory, or our active
+	   page directory will be one that's been freed (and
+	   cleared). */
+	cur->pagedir = NULL;
+	pagedir_activate(NULL);
+
+	/* Hand our usage to the process in one step, so that
+	   process_get_usage() counts it exactly once. */
+	old_level = intr_disable();
+	rusage_add(&p->exited_usage, &cur->usage);
+	cur->process = NULL;
+	intr_set_level(old_level);
+
+	/* The thread that loaded the program is the process as far as
+	   its parent's wait() is concerned, so it goes last: its exit
+	   record is not released until the other threads are gone. */
+	lock_acquire(&p->lock);
+	if (cur->tid == p->main_tid)
+		while (p->thread_cnt > 1)
+			cond_wait(&p->others_done, &p->lock);
+	last = --p->thread_cnt == 0;
+	if (p->thread_cnt == 1)
+		cond_signal(&p->others_done, &p->lock);
+	lock_release(&p->lock);
+	if (!last)
+		return;
+
+	/* Only now that no other thread can still be running code
+	   from it may the executable become writable again. */
+	release_executable(cur);
+	while (!list_empty(&p->files))
+	{
+		struct list_elem *e = list_pop_front(&p->files);
 		struct open_file *of = list_entry(e, struct open_file, elem);
 		file_close(of->file_ptr);
-		list_remove(e);
-		palloc_free_page(of);
+		kmem_cache_free(&open_file_cache, of);
 	}
+	child_record_table_destroy(&p->threads);
+	if (p->pagedir != NULL)
+		pagedir_destroy(p->pagedir);
+	free(p);
+}
 
-	struct list_elem *next;
-	e = list_begin(&cur->children);
+/* Starts a new thread in the current process.  It begins running
+   user code at ENTRY, on a stack of its own, as if ENTRY had been
+   called with arguments FN and AUX.  Returns the new thread's
+   tid, or TID_ERROR if the thread or its stack cannot be
+   created.
 
-	for (; e != list_end(&cur->children); e = next)
+   The new thread shares the process's address space and open
+   files.  Any thread of the process may join it with
+   process_thread_join(); it cannot be waited for with wait(). */
+tid_t process_thread_create(void (*entry)(void), void *fn, void *aux)
+{
+	struct thread *cur = thread_current();
+	struct process *p = cur->process;
+	struct thread_start start;
+	struct child_record *record;
+	tid_t tid;
+
+	start.process = p;
+	start.entry = entry;
+	start.fn = fn;
+	start.aux = aux;
+	sema_init(&start.started, 0);
+
+	lock_acquire(&p->lock);
+	if (p->exiting)
 	{
-		next = list_next(e);
-		struct thread *cp = list_entry(e, struct thread, child_elem);
-		list_remove(&cp->child_elem);
-		// free(cp);
-  }
-
-	/* Destroy the current process's page directory and switch back
-	 to the kernel-only page directory. */
-	pd = cur->pagedir;
-	if (pd != NULL)
+		lock_release(&p->lock);
+		return TID_ERROR;
+	}
+	p->thread_cnt++;
+	lock_release(&p->lock);
+
+	tid = thread_create(cur->name, thread_get_priority(), start_thread, &start, NULL);
+	if (tid == TID_ERROR)
 	{
-		/* Correct ordering here is crucial.  We must set
-		 cur->pagedir to NULL before switching page directories,
-		 so that a timer interrupt can't switch back to the
-		 process page directory.  We must activate the base page
-		 directory before destroying the process's page
-		 directory, or our active page directory will be one
-		 that's been freed (and cleared). */
-		cur->pagedir = NULL;
-		pagedir_activate(NULL);
-		pagedir_destroy(pd);
+		lock_acquire(&p->lock);
+		p->thread_cnt--;
+		lock_release(&p->lock);
+		return TID_ERROR;
 	}
+	sema_down(&start.started);
+
+	/* thread_create() made the new thread our child.  Hand its exit
+	   record to the process instead, so that any of its threads can
+	   join it. */
+	record = thread_find_child(tid);
+	hash_delete(&cur->children, &record->elem);
+	if (!start.success)
+	{
+		child_record_release(record);
+		return TID_ERROR;
+	}
+	lock_acquire(&p->lock);
+	hash_insert(&p->threads, &record->elem);
+	lock_release(&p->lock);
+	return tid;
+}
 
-	if (cur->parent && cur->parent->wait_on == cur->tid)
+/* A thread function that sets up a thread started by
+   process_thread_create() and starts it running in user mode. */
+static void
+start_thread(void *start_)
+{
+	struct thread_start *start = start_;
+	struct thread *t = thread_current();
+	struct intr_frame if_;
+	uint32_t *esp;
+
+	t->process = start->process;
+	t->pagedir = start->process->pagedir;
+	process_activate();
+
+	start->success = alloc_user_stack(t);
+	if (!start->success)
 	{
-		cur->parent->child_exit_status = cur->exit_status;
-		cur->parent->wait_on = -2;
-		list_remove(&cur->child_elem);
-		sema_up(&cur->parent->sync_lock);
+		sema_up(&start->started);
+		thread_exit();
 	}
+
+	/* Build the frame of a call to ENTRY (FN, AUX) that has no
+	   return address to go back to. */
+	esp = (uint32_t *)((uint8_t *)PHYS_BASE - t->stack_slot * USER_STACK_STRIDE);
+	*--esp = (uint32_t)start->aux;
+	*--esp = (uint32_t)start->fn;
+	*--esp = 0;
+
+	memset(&if_, 0, sizeof if_);
+	if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
+	if_.cs = SEL_UCSEG;
+	if_.eflags = FLAG_IF | FLAG_MBS;
+	if_.eip = start->entry;
+	if_.esp = esp;
+
+	/* START lives on our creator's stack, so it is gone once we
+	   let the creator go on. */
+	sema_up(&start->started);
+
+	asm volatile("movl %0, %%esp; jmp intr_exit" : : "g"(&if_) : "memory");
+	NOT_REACHED();
+}
+
+/* Waits for thread TID of the current process, which must have
+   been started by process_thread_create(), to exit.  Returns 0
+   once it has, or -1 at once if TID is not such a thread, is the
+   caller, or has already been joined. */
+int process_thread_join(tid_t tid)
+{
+	struct process *p = thread_current()->process;
+	struct child_record key;
+	struct child_record *record;
+	struct hash_elem *e;
+
+	if (tid == thread_tid())
+		return -1;
+
+	key.tid = tid;
+	lock_acquire(&p->lock);
+	e = hash_delete(&p->threads, &key.elem);
+	lock_release(&p->lock);
+	if (e == NULL)
+		return -1;
+
+	record = hash_entry(e, struct child_record, elem);
+	sema_down(&record->exited);
+	child_record_release(record);
+	return 0;
+}
+
+/* Starts the exit of the current process with STATUS.  The other
+   threads of the process exit the next time they would return to
+   user mode; see process_exit_if_exiting().  Threads waiting on a
+   futex are woken so that they get there.  Returns true if this
+   is the first exit for the process, false if another thread
+   already started one, in which case its status stands. */
+bool process_begin_exit(int status)
+{
+	struct thread *cur = thread_current();
+	struct process *p = cur->process;
+	bool first = true;
+
+	if (p != NULL)
+	{
+		lock_acquire(&p->lock);
+		first = !p->exiting;
+		if (first)
+		{
+			p->exiting = true;
+			p->exit_status = status;
+		}
+		status = p->exit_status;
+		lock_release(&p->lock);
+		if (first)
+			futex_wake_process(p);
+	}
+	cur->exit_status = status;
+	return first;
+}
+
+/* Ends the current thread if its process is exiting.  Called on
+   every return to user mode, so that no thread runs user code
+   once any thread of its process has called exit().  A thread
+   that is blocked in the kernel ends once it is woken. */
+void process_exit_if_exiting(void)
+{
+	struct thread *cur = thread_current();
+	struct process *p = cur->process;
+
+	if (p != NULL && p->exiting)
+	{
+		/* We may be at the end of an external interrupt, but we
+		   are not going back to the code it interrupted. */
+		intr_enable();
+		cur->exit_status = p->exit_status;
+		thread_exit();
+	}
+}
+
+/* Search state for process_get_usage(). */
+struct usage_query
+{
+	tid_t pid;				/* Process to look for. */
+	struct process *process; /* That process, once found. */
+	struct rusage *usage;	/* Sum so far. */
+};
+
+/* thread_foreach() callback that finds the process whose first
+   thread had tid Q->pid. */
+static void
+find_process(struct thread *t, void *q_)
+{
+	struct usage_query *q = q_;
+
+	if (t->process != NULL && t->process->main_tid == q->pid)
+		q->process = t->process;
+}
+
+/* thread_foreach() callback that adds the usage of T to Q's sum
+   if T belongs to Q's process. */
+static void
+add_thread_usage(struct thread *t, void *q_)
+{
+	struct usage_query *q = q_;
+
+	if (t->process == q->process)
+		rusage_add(q->usage, &t->usage);
+}
+
+/* Stores in *USAGE the resources used by WHO, which is
+   RUSAGE_THREAD for the current thread, RUSAGE_SELF for all the
+   threads of the current process, or the pid of any live process
+   for all of its threads.  A process's usage includes its threads
+   that have exited.  Returns true if successful, false if there
+   is no process WHO. */
+bool process_get_usage(tid_t who, struct rusage *usage)
+{
+	struct thread *cur = thread_current();
+	struct usage_query q;
+	enum intr_level old_level;
+
+	q.pid = who;
+	q.process = who == RUSAGE_SELF ? cur->process : NULL;
+	q.usage = usage;
+
+	old_level = intr_disable();
+	if (who == RUSAGE_THREAD)
+		*usage = cur->usage;
+	else
+	{
+		if (q.process == NULL && who > 0)
+			thread_foreach(find_process, &q);
+		if (q.process != NULL)
+		{
+			*usage = q.process->exited_usage;
+			thread_foreach(add_thread_usage, &q);
+		}
+	}
+	intr_set_level(old_level);
+
+	return who == RUSAGE_THREAD || q.process != NULL;
+}
+
+/* Adds the counts in B to those in A. */
+static void
+rusage_add(struct rusage *a, const struct rusage *b)
+{
+	a->user_ticks += b->user_ticks;
+	a->kernel_ticks += b->kernel_ticks;
+	a->voluntary_switches += b->voluntary_switches;
+	a->involuntary_switches += b->involuntary_switches;
+	a->page_faults += b->page_faults;
 }
 
 /* Sets up the CPU for running user code in the current
@@ -303,7 +648,7 @@ bool load(const char *file_name, void (**eip)(void), void **esp, char **save_ptr
 	int i;
 
 	/* Allocate and activate page directory. */
-	t->pagedir = pagedir_create();
+	t->pagedir = t->process->pagedir = pagedir_create();
 	if (t->pagedir == NULL)
 		goto done;
 	process_activate();
@@ -595,6 +940,67 @@ setup_stack(void **esp, const char *file_name, char **save_ptr)
 	}
 }
 
+/* Returns the page at the top of the user stack in slot SLOT. */
+static void *
+user_stack_page(int slot)
+{
+	return (uint8_t *)PHYS_BASE - slot * USER_STACK_STRIDE - PGSIZE;
+}
+
+/* Gives T, a new thread of the current process, a user stack of
+   one zeroed page in a free stack slot.  Returns true if
+   successful, false if the process has no free slot or memory
+   runs out. */
+static bool
+alloc_user_stack(struct thread *t)
+{
+	struct process *p = t->process;
+	uint8_t *kpage;
+	int slot;
+
+	kpage = palloc_get_page(PAL_USER | PAL_ZERO);
+	if (kpage == NULL)
+		return false;
+
+	lock_acquire(&p->lock);
+	for (slot = 1; slot < PROCESS_MAX_THREADS; slot++)
+		if ((p->stack_slots & (1u << slot)) == 0)
+			break;
+	if (slot == PROCESS_MAX_THREADS || !install_page(user_stack_page(slot), kpage, true))
+	{
+		lock_release(&p->lock);
+		palloc_free_page(kpage);
+		return false;
+	}
+	p->stack_slots |= 1u << slot;
+	lock_release(&p->lock);
+
+	t->stack_slot = slot;
+	return true;
+}
+
+/* Unmaps and frees the user stack of T, a thread of the current
+   process, unless it is the first thread's, which goes with the
+   page directory. */
+static void
+free_user_stack(struct thread *t)
+{
+	struct process *p = t->process;
+	void *upage = user_stack_page(t->stack_slot);
+	void *kpage;
+
+	if (t->stack_slot == 0)
+		return;
+
+	lock_acquire(&p->lock);
+	kpage = pagedir_get_page(p->pagedir, upage);
+	pagedir_clear_page(p->pagedir, upage);
+	palloc_free_page(kpage);
+	p->stack_slots &= ~(1u << t->stack_slot);
+	lock_release(&p->lock);
+	t->stack_slot = 0;
+}
+
 /* Adds a mapping from user virtual address UPAGE to kernel
    virtual address KPAGE to the page table.
    If WRITABLE is true, the user process may modify the page;
@@ -1,11 +1,50 @@
 #ifndef USERPROG_PROCESS_H
 #define USERPROG_PROCESS_H
 
+#include <hash.h>
+#include <list.h>
+#include <rusage.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/synch.h"
 #include "threads/thread.h"
 
+/* Maximum number of threads in a process at once, counting the
+   thread that started it.  Each one has its own user stack. */
+#define PROCESS_MAX_THREADS 32
+
+/* State shared by all the threads of a user process.  The thread
+   that loads the program creates it; further threads join it
+   through the thread_create system call, and the last thread to
+   exit destroys it. */
+struct process
+{
+	struct lock lock;		 /* Protects the members below. */
+	uint32_t *pagedir;		 /* Page directory. */
+	tid_t main_tid;			 /* Thread that loaded the program. */
+	int thread_cnt;			 /* # of threads using the process. */
+	struct condition others_done; /* Signaled when thread_cnt drops to 1. */
+	uint32_t stack_slots;	 /* Bitmap of user stacks in use. */
+	struct hash threads;	 /* Exit records of joinable threads. */
+	bool exiting;			 /* Set by the first exit(). */
+	int exit_status;		 /* Status passed to that exit(). */
+	struct rusage exited_usage; /* Summed over threads that exited. */
+
+	/* Open files, shared by all the threads. */
+	int files_cnt;
+	struct list files;
+	int next_fd;
+};
+
 tid_t process_execute (const char *file_name);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
 
+tid_t process_thread_create (void (*entry) (void), void *fn, void *aux);
+int process_thread_join (tid_t);
+bool process_begin_exit (int status);
+void process_exit_if_exiting (void);
+bool process_get_usage (tid_t who, struct rusage *);
+
 #endif /* userprog/process.h */
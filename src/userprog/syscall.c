@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <syscall-nr.h>
 #include "threads/interrupt.h"
+#include "threads/kmem.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "devices/shutdown.h"
@@ -9,14 +10,22 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "string.h"
-#include "threads/palloc.h"
+#include "userprog/futex.h"
+#include "userprog/process.h"
 // #include "lib/kernel/console.c"
 
 #define STDIN_FILENO 0
 #define STDOUT_FILENO 1
 #define STDERR_FILENO 2
 
-struct lock fs_lock;
+/* Serializes file system access.  Calls that only look at file
+   state take it shared; everything else takes it exclusive. */
+struct rwlock fs_lock;
+
+/* Open-file entries, one per descriptor a process holds. */
+struct kmem_cache open_file_cache =
+    KMEM_CACHE_INITIALIZER("open_file", sizeof(struct open_file),
+                           __alignof__(struct open_file), NULL);
 
 void verify_esp(void *esp);
 static void syscall_handler(struct intr_frame *f);
@@ -26,7 +35,8 @@ const int MAX_FILE_NAME_LENGTH = 14;
 void syscall_init(void)
 {
   intr_register_int(0x30, 3, INTR_ON, syscall_handler, "syscall");
-  lock_init(&fs_lock);
+  rwlock_init(&fs_lock);
+  futex_init();
 }
 
 static void
@@ -90,6 +100,27 @@ syscall_handler(struct intr_frame *f)
     // verify_buffer(args[0], 1);
     sys_file_close(args[0]);
     break;
+  case SYS_FUTEX_WAIT:
+    verify_word((void *)args[0]);
+    f->eax = futex_wait((int *)args[0], args[1]) ? 0 : -1;
+    break;
+  case SYS_FUTEX_WAKE:
+    verify_word((void *)args[0]);
+    f->eax = futex_wake((int *)args[0], args[1]);
+    break;
+  case SYS_THREAD_CREATE:
+    f->eax = process_thread_create((void (*)(void))args[0], (void *)args[1], (void *)args[2]);
+    break;
+  case SYS_THREAD_EXIT:
+    sys_thread_exit();
+    break;
+  case SYS_THREAD_JOIN:
+    f->eax = process_thread_join(args[0]);
+    break;
+  case SYS_GETRUSAGE:
+    verify_buffer((void *)args[1], sizeof(struct rusage));
+    f->eax = sys_getrusage(args[0], (struct rusage *)args[1]);
+    break;
   default:
     sys_exit(-1);
   }
@@ -105,6 +136,15 @@ void verify_esp(void *esp)
   }
 }
 
+/* Exits if ADDR is not a mapped, int-aligned user address.  An
+   aligned int never straddles two pages. */
+void verify_word(void *addr)
+{
+  if ((uintptr_t)addr % sizeof(int) != 0)
+    sys_exit(-1);
+  verify_esp(addr);
+}
+
 void verify_string(const void *str)
 {
   verify_esp((void *)str);
@@ -165,6 +205,18 @@ int get_number_of_args(int syscall_number)
     return 1;
   case SYS_CLOSE:
     return 1;
+  case SYS_FUTEX_WAIT:
+    return 2;
+  case SYS_FUTEX_WAKE:
+    return 2;
+  case SYS_THREAD_CREATE:
+    return 3;
+  case SYS_THREAD_EXIT:
+    return 0;
+  case SYS_THREAD_JOIN:
+    return 1;
+  case SYS_GETRUSAGE:
+    return 2;
   default:
     sys_exit(-1);
     return -1;
@@ -180,35 +232,85 @@ void load_args(int *esp, int *args, int numberOfArgs)
   }
 }
 
+/* Ends the current process with STATUS.  Its other threads end
+   the next time they would return to user mode. */
 void sys_exit(int status)
 {
   struct thread *current_thread = thread_current();
-  current_thread->exit_status = status;
-  if (current_thread->executable != NULL)
-  {
-    file_allow_write(current_thread->executable);
-    file_close(current_thread->executable);
-  }
 
-  printf("%s: exit(%d)\n", current_thread->name, status);
+  if (process_begin_exit(status))
+    printf("%s: exit(%d)\n", current_thread->name, status);
   thread_exit();
 }
 
-struct file *my_get_file(int fd)
+/* Stores in *USAGE the resources used by WHO; see
+   process_get_usage(). */
+bool sys_getrusage(int who, struct rusage *usage)
+{
+  struct rusage u;
+
+  if (!process_get_usage(who, &u))
+    return false;
+  memcpy(usage, &u, sizeof u);
+  return true;
+}
+
+/* Ends the current thread.  In the thread that started the
+   process this is the same as exit(0). */
+void sys_thread_exit(void)
+{
+  struct thread *t = thread_current();
+
+  if (t->tid == t->process->main_tid)
+    sys_exit(0);
+  thread_exit();
+}
+
+/* Returns the open file for FD, or a null pointer if FD is not
+   open.  The caller must give the file back with my_put_file(),
+   so that another thread of the process closing FD in the
+   meantime does not close the file under it. */
+struct open_file *my_get_file(int fd)
 {
   if (fd < 0 || fd < SYSTEM_FILES)
     return NULL;
 
   // printf("my get file and fd is : %d caller is : %s\n", fd, caller_name);
-  struct thread *t = thread_current();
+  struct process *p = thread_current()->process;
+  struct open_file *file = NULL;
   struct list_elem *e;
-  for (e = list_begin(&t->files); e != list_end(&t->files); e = list_next(e))
+  lock_acquire(&p->lock);
+  for (e = list_begin(&p->files); e != list_end(&p->files); e = list_next(e))
   {
     struct open_file *of = list_entry(e, struct open_file, elem);
     if (of->fd == fd)
-      return of->file_ptr;
+    {
+      file = of;
+      file->ref_cnt++;
+      break;
+    }
   }
-  return NULL;
+  lock_release(&p->lock);
+  return file;
+}
+
+/* Drops a reference to OF, taken by my_get_file() or held by the
+   fd table, and closes the file once the last one is gone. */
+void my_put_file(struct open_file *of)
+{
+  struct process *p = thread_current()->process;
+  bool last;
+
+  lock_acquire(&p->lock);
+  last = --of->ref_cnt == 0;
+  lock_release(&p->lock);
+  if (!last)
+    return;
+
+  rwlock_acquire_write(&fs_lock);
+  file_close(of->file_ptr);
+  rwlock_release_write(&fs_lock);
+  kmem_cache_free(&open_file_cache, of);
 }
 
 int sys_file_open(const char *file_name)
@@ -223,23 +325,29 @@ int sys_file_open(const char *file_name)
 
   // printf("file name is empty\n file name : %s\n", file_name);
   // printf("reached here in open -> 1 file name is : %s\n", file_name);
-  lock_acquire(&fs_lock);
+  rwlock_acquire_write(&fs_lock);
   struct file *opened_file = filesys_open(file_name);
-  lock_release(&fs_lock);
+  rwlock_release_write(&fs_lock);
   // printf("reached here in open -> 2 file name is : %s and there's a file opened = %d\n", file_name, opened_file != NULL);
 
   if (opened_file != NULL)
   {
-    struct thread *t = thread_current();
-    struct open_file *file = palloc_get_page(PAL_ZERO);
+    struct process *p = thread_current()->process;
+    struct open_file *file = kmem_cache_alloc(&open_file_cache);
     if (file == NULL)
+    {
+      file_close(opened_file);
       return -1;
+    }
 
     file->file_ptr = opened_file;
     file->name = file_name;
-    file->fd = t->next_fd++;
+    file->ref_cnt = 1;
 
-    list_push_back(&t->files, &file->elem);
+    lock_acquire(&p->lock);
+    file->fd = p->next_fd++;
+    list_push_back(&p->files, &file->elem);
+    lock_release(&p->lock);
     return file->fd;
     // printf("reached here in open -> 2 file name is : %s returned fd is : %d\n", file_name, t->files_cnt - 1);
   }
@@ -260,13 +368,14 @@ int sys_file_write(int fd, void *buffer, unsigned size)
     // printf("write finish\n");
   }
 
-  struct file *cur_file = my_get_file(fd);
+  struct open_file *cur_file = my_get_file(fd);
   if (cur_file == NULL)
     return -1;
 
-  lock_acquire(&fs_lock);
-  size = file_write(cur_file, buffer, (off_t)size);
-  lock_release(&fs_lock);
+  rwlock_acquire_write(&fs_lock);
+  size = file_write(cur_file->file_ptr, buffer, (off_t)size);
+  rwlock_release_write(&fs_lock);
+  my_put_file(cur_file);
 
   return size;
 }
@@ -288,11 +397,14 @@ void sys_file_seek(int fd, unsigned new_pos)
   if (fd < SYSTEM_FILES)
     sys_exit(-1);
 
-  struct file *cur_file = my_get_file(fd);
+  struct open_file *cur_file = my_get_file(fd);
+  if (cur_file == NULL)
+    return;
 
-  lock_acquire(&fs_lock);
-  file_seek(cur_file, (off_t)new_pos);
-  lock_release(&fs_lock);
+  rwlock_acquire_write(&fs_lock);
+  file_seek(cur_file->file_ptr, (off_t)new_pos);
+  rwlock_release_write(&fs_lock);
+  my_put_file(cur_file);
 }
 
 int sys_file_tell(int fd)
@@ -300,11 +412,14 @@ int sys_file_tell(int fd)
   if (fd < SYSTEM_FILES)
     sys_exit(-1);
 
-  struct file *cur_file = my_get_file(fd);
+  struct open_file *cur_file = my_get_file(fd);
+  if (cur_file == NULL)
+    return -1;
 
-  lock_acquire(&fs_lock);
-  off_t off = file_tell(cur_file);
-  lock_release(&fs_lock);
+  rwlock_acquire_read(&fs_lock);
+  off_t off = file_tell(cur_file->file_ptr);
+  rwlock_release_read(&fs_lock);
+  my_put_file(cur_file);
 
   return off;
 }
@@ -314,11 +429,14 @@ int sys_file_size(int fd)
   if (fd < SYSTEM_FILES)
     sys_exit(-1);
 
-  struct file *cur_file = my_get_file(fd);
+  struct open_file *cur_file = my_get_file(fd);
+  if (cur_file == NULL)
+    return -1;
 
-  lock_acquire(&fs_lock);
-  off_t off = file_length(cur_file);
-  lock_release(&fs_lock);
+  rwlock_acquire_read(&fs_lock);
+  off_t off = file_length(cur_file->file_ptr);
+  rwlock_release_read(&fs_lock);
+  my_put_file(cur_file);
 
   return off;
 }
@@ -329,9 +447,9 @@ bool sys_file_remove(const char *file_name)
   if (file_name == NULL || !strcmp(file_name, empty_str))
     sys_exit(-1);
 
-  lock_acquire(&fs_lock);
+  rwlock_acquire_write(&fs_lock);
   bool success = filesys_remove(file_name);
-  lock_release(&fs_lock);
+  rwlock_release_write(&fs_lock);
 
   if (success)
     remove_file_from_table(file_name);
@@ -340,20 +458,25 @@ bool sys_file_remove(const char *file_name)
 
 void remove_file_from_table(const char *name)
 {
-  struct thread *t = thread_current();
+  struct process *p = thread_current()->process;
+  struct open_file *removed = NULL;
   struct list_elem *e;
 
-  for (e = list_begin(&t->files); e != list_end(&t->files); e = list_next(e))
+  lock_acquire(&p->lock);
+  for (e = list_begin(&p->files); e != list_end(&p->files); e = list_next(e))
   {
     struct open_file *of = list_entry(e, struct open_file, elem);
     if (of->name == name)
     {
       list_remove(&of->elem);
-      palloc_free_page(of);
-      t->files_cnt--;
-      return;
+      p->files_cnt--;
+      removed = of;
+      break;
     }
   }
+  lock_release(&p->lock);
+  if (removed != NULL)
+    my_put_file(removed);
 }
 
 bool sys_file_create(const char *file_name, unsigned size)
@@ -365,9 +488,9 @@ bool sys_file_create(const char *file_name, unsigned size)
   if (strlen(file_name) > MAX_FILE_NAME_LENGTH)
     return 0;
 
-  lock_acquire(&fs_lock);
+  rwlock_acquire_write(&fs_lock);
   bool success = filesys_create(file_name, (off_t)size);
-  lock_release(&fs_lock);
+  rwlock_release_write(&fs_lock);
   return success;
 }
 
@@ -379,10 +502,11 @@ int sys_file_read(int fd, void *buffer, unsigned length)
   if (fd < SYSTEM_FILES)
     handle_read_from_system_files(fd, buffer, length);
 
-  struct file *file_to_read_from = my_get_file(fd);
+  struct open_file *file_to_read_from = my_get_file(fd);
   if (file_to_read_from == NULL)
     return -1;
-  int actual_read = file_read(file_to_read_from, buffer, length);
+  int actual_read = file_read(file_to_read_from->file_ptr, buffer, length);
+  my_put_file(file_to_read_from);
   return actual_read;
 }
 
@@ -407,37 +531,49 @@ void sys_file_close(int fd)
   if (fd < SYSTEM_FILES || fd > MAX_FILES_PER_PROCESS)
     sys_exit(-1);
 
-  struct thread *t = thread_current();
+  struct process *p = thread_current()->process;
+  struct open_file *closed = NULL;
   struct list_elem *e;
 
-  for (e = list_begin(&t->files); e != list_end(&t->files); e = list_next(e))
+  /* Take FD out of the table under the process lock, but close
+     the file only after dropping it: file_close() takes fs_lock,
+     and another thread may still be using the file. */
+  lock_acquire(&p->lock);
+  for (e = list_begin(&p->files); e != list_end(&p->files); e = list_next(e))
   {
     struct open_file *of = list_entry(e, struct open_file, elem);
     if (of != NULL && of->fd == fd)
     {
-      file_close(of->file_ptr);
       list_remove(&of->elem);
-      palloc_free_page(of);
-      t->files_cnt--;
-      return;
+      p->files_cnt--;
+      closed = of;
+      break;
     }
   }
+  lock_release(&p->lock);
+  if (closed != NULL)
+    my_put_file(closed);
 }
 
 void remove_file_from_table_by_fd(int fd)
 {
-  struct thread *t = thread_current();
+  struct process *p = thread_current()->process;
+  struct open_file *removed = NULL;
   struct list_elem *e;
 
-  for (e = list_begin(&t->files); e != list_end(&t->files); e = list_next(e))
+  lock_acquire(&p->lock);
+  for (e = list_begin(&p->files); e != list_end(&p->files); e = list_next(e))
   {
     struct open_file *of = list_entry(e, struct open_file, elem);
     if (of->fd == fd)
     {
       list_remove(&of->elem);
-      palloc_free_page(of);
-      t->files_cnt--;
-      return;
+      p->files_cnt--;
+      removed = of;
+      break;
     }
   }
+  lock_release(&p->lock);
+  if (removed != NULL)
+    my_put_file(removed);
 }
\ No newline at end of file
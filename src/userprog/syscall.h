@@ -1,11 +1,16 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <rusage.h>
 #include "filesys/off_t.h"
+#include "threads/kmem.h"
 
 /* lock to the file system so that only one process can enter it */
 
 
+/* Cache of struct open_file, shared with process_exit(). */
+extern struct kmem_cache open_file_cache;
+
 void syscall_init (void);
 // System call handler and initialization
 void syscall_init(void);
@@ -14,13 +19,15 @@ void syscall_init(void);
 void verify_esp(void *esp);
 void verify_string(const void *str);
 void verify_buffer(void *buffer, unsigned size);
+void verify_word(void *addr);
 
 // Argument handling
 int get_number_of_args(int syscall_number);
 void load_args(int *esp, int *args, int numberOfArgs);
 
 // File operations
-struct file *my_get_file(int fd);
+struct open_file *my_get_file(int fd);
+void my_put_file(struct open_file *of);
 int sys_file_open(const char* file_name);
 int sys_file_write(int fd, void* buffer, unsigned size);
 void handle_sys_files(int fd, const char *buffer, unsigned size);
@@ -34,5 +41,7 @@ void sys_file_close(int fd);
 
 // Process management
 void sys_exit(int status);
+void sys_thread_exit(void);
+_Bool sys_getrusage(int who, struct rusage *usage);
 static int sys_exec(const char *cmd_line);
 #endif /* userprog/syscall.h */
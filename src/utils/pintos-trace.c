@@ -0,0 +1,161 @@
+/* Decodes the scheduler event trace that a Pintos kernel run
+   with "-trace" writes to the serial port at power-off, and
+   prints it as a timeline.
+
+   The trace is found by scanning the input, normally a capture of
+   the serial output, for the dump header, so any console output
+   around it is skipped.  Run the kernel so that the capture is
+   byte-exact, e.g. "pintos ... > output" rather than through a
+   terminal. */
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Must match struct trace_header in threads/trace.c. */
+struct trace_header
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t event_size;
+    uint32_t event_cnt;
+    uint32_t recorded;
+    uint32_t timer_freq;
+  };
+
+/* Must match struct trace_event in threads/trace.h. */
+struct trace_event
+  {
+    uint64_t tsc;
+    uint32_t tick;
+    int32_t tid;
+    int32_t arg;
+    uint8_t type;
+    uint8_t priority;
+    uint16_t pad;
+  };
+
+#define TRACE_VERSION 1
+
+/* Must match enum trace_type in threads/trace.h. */
+enum trace_type
+  {
+    TRACE_SWITCH_OUT, TRACE_SWITCH_IN, TRACE_BLOCK, TRACE_UNBLOCK,
+    TRACE_DONATE, TRACE_SLEEP, TRACE_WAKE
+  };
+
+/* Names of the trace event types, indexed by enum trace_type. */
+static const char *type_names[] =
+  {"switch-out", "switch-in", "block", "unblock", "donate", "sleep", "wake"};
+
+/* Names of thread states, indexed by enum thread_status. */
+static const char *status_names[] = {"running", "ready", "blocked", "dying"};
+
+static void
+usage (const char *program_name)
+{
+  fprintf (stderr,
+           "pintos-trace: prints a Pintos scheduler trace as a timeline\n"
+           "usage: %s [FILE]\n"
+           "  where FILE holds the serial output of a run with -trace\n"
+           "  (default: standard input).\n",
+           program_name);
+  exit (EXIT_FAILURE);
+}
+
+/* Reads all of F into a malloc()'d buffer and stores its size in
+   *SIZE. */
+static unsigned char *
+read_all (FILE *f, size_t *size)
+{
+  size_t cap = 65536;
+  unsigned char *buf = malloc (cap);
+  size_t n;
+
+  *size = 0;
+  while (buf != NULL && (n = fread (buf + *size, 1, cap - *size, f)) > 0)
+    {
+      *size += n;
+      if (*size == cap)
+        buf = realloc (buf, cap *= 2);
+    }
+  if (buf == NULL)
+    {
+      fprintf (stderr, "pintos-trace: out of memory\n");
+      exit (EXIT_FAILURE);
+    }
+  return buf;
+}
+
+int
+main (int argc, char *argv[])
+{
+  FILE *f = stdin;
+  unsigned char *buf, *p, *start;
+  struct trace_header h;
+  uint64_t first_tsc = 0;
+  size_t size;
+  uint32_t i;
+
+  if (argc > 2 || (argc == 2 && argv[1][0] == '-'))
+    usage (argv[0]);
+  if (argc == 2 && (f = fopen (argv[1], "rb")) == NULL)
+    {
+      perror (argv[1]);
+      return EXIT_FAILURE;
+    }
+  buf = read_all (f, &size);
+
+  /* Find the last dump header in the input. */
+  start = NULL;
+  for (p = buf; p + sizeof h <= buf + size; p++)
+    if (!memcmp (p, "PINTRACE", 8))
+      start = p;
+  if (start == NULL)
+    {
+      fprintf (stderr, "pintos-trace: no trace found in input\n");
+      return EXIT_FAILURE;
+    }
+  memcpy (&h, start, sizeof h);
+  p = start + sizeof h;
+  if (h.version != TRACE_VERSION || h.event_size != sizeof (struct trace_event))
+    {
+      fprintf (stderr, "pintos-trace: unsupported trace version %"PRIu32"\n",
+               h.version);
+      return EXIT_FAILURE;
+    }
+  if ((size_t) (buf + size - p) / h.event_size < h.event_cnt)
+    {
+      fprintf (stderr, "pintos-trace: trace truncated, decoding what is there\n");
+      h.event_cnt = (buf + size - p) / h.event_size;
+    }
+
+  printf ("# %"PRIu32" events (%"PRIu32" recorded, %"PRIu32" lost), "
+          "%"PRIu32" ticks per second\n",
+          h.event_cnt, h.recorded, h.recorded - h.event_cnt, h.timer_freq);
+  printf ("# %8s %14s %6s %4s  %s\n", "tick", "cycles", "tid", "pri", "event");
+  for (i = 0; i < h.event_cnt; i++, p += h.event_size)
+    {
+      struct trace_event e;
+      const char *name;
+
+      memcpy (&e, p, sizeof e);
+      if (i == 0)
+        first_tsc = e.tsc;
+      name = e.type < sizeof type_names / sizeof *type_names
+             ? type_names[e.type] : "?";
+      printf ("  %8"PRIu32" %14"PRIu64" %6"PRId32" %4u  %s",
+              e.tick, e.tsc - first_tsc, e.tid, e.priority, name);
+      if (e.type == TRACE_SWITCH_OUT && e.arg >= 0
+          && (size_t) e.arg < sizeof status_names / sizeof *status_names)
+        printf (" -> %s", status_names[e.arg]);
+      else if (e.type == TRACE_DONATE)
+        printf (" from %"PRId32, e.arg);
+      else if (e.type == TRACE_SLEEP)
+        printf (" until %"PRId32, e.arg);
+      putchar ('\n');
+    }
+  return EXIT_SUCCESS;
+}